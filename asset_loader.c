@@ -1,5 +1,6 @@
 #include "asset_loader.h"
 #include "darray.h"
+#include "simd.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -11,6 +12,23 @@ read_uint32(const uint8_t* data, uint32_t* pos) {
     return value;
 }
 
+static uint32_t
+pow2_mask(uint32_t size) {
+    return size && !(size & (size - 1)) ? size - 1 : 0;
+}
+
+static int
+texel_floor(float t, uint32_t size) {
+    float f = t * size;
+    int i = (int)f;
+    return i - (f < i);
+}
+
+static uint32_t
+level_size(uint32_t size, uint32_t level) {
+    return (size >> level) ? (size >> level) : 1;
+}
+
 static void
 read_data(const uint8_t* src, uint32_t* pos, void* dst, size_t size) {
     memcpy(dst, src + *pos, size);
@@ -78,19 +96,41 @@ asset_blob_load(asset_blob_t* blob) {
                 }
 
                 asset_texture_t* tex = &blob->textures[blob->texture_count];
+                uint32_t chunk_end = blob->position + chunk_hdr.chunk_size;
                 
                 tex->width = read_uint32(blob->data, &blob->position);
                 tex->height = read_uint32(blob->data, &blob->position);
                 tex->format = read_uint32(blob->data, &blob->position);
+                tex->wrap_x = pow2_mask(tex->width);
+                tex->wrap_y = pow2_mask(tex->height);
+
+                if (tex->format == TEXTURE_FORMAT_TILED &&
+                    (tex->width % TEXTURE_TILE_SIZE || tex->height % TEXTURE_TILE_SIZE)) {
+                    printf("  Tiled texture size is not a multiple of %d, reading it as linear\n",
+                           TEXTURE_TILE_SIZE);
+                    tex->format = TEXTURE_FORMAT_LINEAR;
+                }
                 
                 tex->pixels = blob->data + blob->position;
                 
                 uint32_t pixel_data_size = tex->width * tex->height * 4;
                 blob->position += pixel_data_size;
 
-                printf("  Texture [%u]: %ux%u, format=%u (%.2f KB)\n", 
+                tex->levels[0] = tex->pixels;
+                tex->level_count = 1;
+                while (tex->level_count < TEXTURE_MAX_LEVELS &&
+                       (tex->width >> tex->level_count || tex->height >> tex->level_count)) {
+                    uint32_t size = level_size(tex->width, tex->level_count) *
+                                    level_size(tex->height, tex->level_count) * 4;
+                    if (chunk_end - blob->position < size) break;
+                    tex->levels[tex->level_count++] = blob->data + blob->position;
+                    blob->position += size;
+                }
+                blob->position = chunk_end;
+
+                printf("  Texture [%u]: %ux%u, format=%u, levels=%u (%.2f KB)\n", 
                        blob->texture_count, tex->width, tex->height, tex->format,
-                       pixel_data_size / 1024.0f);
+                       tex->level_count, pixel_data_size / 1024.0f);
 
                 blob->texture_count++;
                 break;
@@ -104,6 +144,7 @@ asset_blob_load(asset_blob_t* blob) {
                 }
 
                 asset_mesh_t* mesh = &blob->meshes[blob->mesh_count];
+                uint32_t chunk_end = blob->position + chunk_hdr.chunk_size;
                 
                 mesh->vertex_count = read_uint32(blob->data, &blob->position);
                 mesh->index_count = read_uint32(blob->data, &blob->position);
@@ -136,6 +177,10 @@ asset_blob_load(asset_blob_t* blob) {
                     (const uint32_t*)(blob->data + blob->position) : NULL;
                 blob->position += mesh->uv_index_count * sizeof(uint32_t);
 
+                mesh->bounds = (chunk_end - blob->position >= 6 * sizeof(float)) ?
+                    (const float*)(blob->data + blob->position) : NULL;
+                if (mesh->bounds) blob->position += 6 * sizeof(float);
+
                 printf("  Mesh [%u]:\n", blob->mesh_count);
                 printf("    Vertices: %u\n", mesh->vertex_count);
                 printf("    Indices: %u\n", mesh->index_count);
@@ -199,7 +244,9 @@ asset_mesh_to_mesh(const asset_mesh_t* asset_mesh) {
         da_create(sizeof(float)),
         da_create(sizeof(uint32_t)),
         mat4_identity,
-        NULL
+        NULL,
+        vec3_zero,
+        vec3_zero
     };
 
     if (asset_mesh->vertex_count > 0 && asset_mesh->vertices) {
@@ -218,6 +265,8 @@ asset_mesh_to_mesh(const asset_mesh_t* asset_mesh) {
         da_resize(mesh.normals, asset_mesh->normal_count);
         memcpy(mesh.normals->data, asset_mesh->normals, 
                asset_mesh->normal_count * sizeof(float));
+    } else {
+        mesh_normals_compute(&mesh);
     }
 
     if (asset_mesh->color_count > 0 && asset_mesh->colors) {
@@ -238,30 +287,250 @@ asset_mesh_to_mesh(const asset_mesh_t* asset_mesh) {
                asset_mesh->uv_index_count * sizeof(uint32_t));
     }
 
+    if (asset_mesh->bounds) {
+        mesh.bounds_min = (vec3_t) {{ asset_mesh->bounds[0], asset_mesh->bounds[1], asset_mesh->bounds[2] }};
+        mesh.bounds_max = (vec3_t) {{ asset_mesh->bounds[3], asset_mesh->bounds[4], asset_mesh->bounds[5] }};
+    } else {
+        mesh_bounds_compute(&mesh);
+    }
+
     return mesh;
 }
 
 uint32_t
 asset_texture_get_color(const asset_texture_t* texture, float u, float v) {
+    return asset_texture_get_color_level(texture, u, v, 0);
+}
+
+uint32_t
+asset_texture_level(const asset_texture_t* texture, float uv_area) {
+    uint32_t level = 0;
+    if (!texture || texture->level_count < 2) {
+        return 0;
+    }
+
+    float texels = uv_area * texture->width * texture->height;
+    while (texels >= 2.0f && level + 1 < texture->level_count) {
+        texels *= 0.25f;
+        level++;
+    }
+    return level;
+}
+
+typedef struct {
+    const uint32_t* pixels;
+    int width, height;
+    int wrap;
+    int mask_x, mask_y;
+    int tiled;
+} texture_level_t;
+
+static void
+texture_level_get(texture_level_t* l, const asset_texture_t* texture, uint32_t level) {
+    if (level >= texture->level_count) level = 0;
+    l->pixels = (const uint32_t*)(level ? texture->levels[level] : texture->pixels);
+    l->width = level_size(texture->width, level);
+    l->height = level_size(texture->height, level);
+    l->wrap = texture->wrap_x && texture->wrap_y;
+    l->mask_x = texture->wrap_x >> level;
+    l->mask_y = texture->wrap_y >> level;
+    l->tiled = texture->format == TEXTURE_FORMAT_TILED &&
+               !(l->width % TEXTURE_TILE_SIZE) && !(l->height % TEXTURE_TILE_SIZE);
+}
+
+static INLINE int
+texel_index(const texture_level_t* l, int x, int y) {
+    if (l->tiled) {
+        return ((y / TEXTURE_TILE_SIZE) * (l->width / TEXTURE_TILE_SIZE) + x / TEXTURE_TILE_SIZE)
+               * (TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE)
+             + (y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + x % TEXTURE_TILE_SIZE;
+    }
+    return y * l->width + x;
+}
+
+static INLINE int
+texel_address(int x, int size, int wrap, int mask) {
+    if (wrap) return x & mask;
+    return x < 0 ? 0 : (x >= size ? size - 1 : x);
+}
+
+static INLINE uint32_t
+texel_nearest(const texture_level_t* l, float u, float v) {
+    int x, y;
+
+    if (l->wrap) {
+        x = texel_floor(u, l->width) & l->mask_x;
+        y = texel_floor(v, l->height) & l->mask_y;
+    } else {
+        if (u < 0.0f) u = 0.0f;
+        if (u > 1.0f) u = 1.0f;
+        if (v < 0.0f) v = 0.0f;
+        if (v > 1.0f) v = 1.0f;
+
+        x = (int)(u * (l->width - 1) + 0.5f);
+        y = (int)(v * (l->height - 1) + 0.5f);
+
+        if (x < 0) x = 0;
+        if (x >= l->width) x = l->width - 1;
+        if (y < 0) y = 0;
+        if (y >= l->height) y = l->height - 1;
+    }
+
+    return l->pixels[texel_index(l, x, y)];
+}
+
+static INLINE void
+texel_weights(int fx, int fy, uint32_t* w) {
+    w[0] = ((256 - fx) * (256 - fy)) >> 8;
+    w[1] = (fx * (256 - fy)) >> 8;
+    w[2] = ((256 - fx) * fy) >> 8;
+    w[3] = 256 - w[0] - w[1] - w[2];
+}
+
+static INLINE uint32_t
+texel_blend(const uint32_t* t, const uint32_t* w) {
+    uint32_t rb = 0, ag = 0;
+    int i;
+    for (i = 0; i < 4; i++) {
+        rb += (t[i] & 0x00ff00ff) * w[i];
+        ag += ((t[i] >> 8) & 0x00ff00ff) * w[i];
+    }
+    return ((rb >> 8) & 0x00ff00ff) | (ag & 0xff00ff00);
+}
+
+static INLINE float
+texel_coord(float t, int size, int wrap) {
+    float f = t * size - 0.5f;
+    if (!wrap) f = f < -1.0f ? -1.0f : (f > (float)size ? (float)size : f);
+    return f;
+}
+
+static INLINE void
+texel_taps(const texture_level_t* l, int x0, int y0, uint32_t* t) {
+    int xa = texel_address(x0, l->width, l->wrap, l->mask_x);
+    int xb = texel_address(x0 + 1, l->width, l->wrap, l->mask_x);
+    int ya = texel_address(y0, l->height, l->wrap, l->mask_y);
+    int yb = texel_address(y0 + 1, l->height, l->wrap, l->mask_y);
+    t[0] = l->pixels[texel_index(l, xa, ya)];
+    t[1] = l->pixels[texel_index(l, xb, ya)];
+    t[2] = l->pixels[texel_index(l, xa, yb)];
+    t[3] = l->pixels[texel_index(l, xb, yb)];
+}
+
+static INLINE uint32_t
+texel_bilinear(const texture_level_t* l, float u, float v) {
+    float fu = texel_coord(u, l->width, l->wrap);
+    float fv = texel_coord(v, l->height, l->wrap);
+    int x0 = (int)fu - (fu < (int)fu);
+    int y0 = (int)fv - (fv < (int)fv);
+    uint32_t t[4], w[4];
+
+    texel_taps(l, x0, y0, t);
+    texel_weights((int)((fu - x0) * 256.0f), (int)((fv - y0) * 256.0f), w);
+    return texel_blend(t, w);
+}
+
+uint32_t
+asset_texture_get_color_level(const asset_texture_t* texture, float u, float v, uint32_t level) {
+    texture_level_t l;
+
     if (!texture || !texture->pixels) {
         return 0xFFFFFFFF;
     }
 
-    if (u < 0.0f) u = 0.0f;
-    if (u > 1.0f) u = 1.0f;
-    if (v < 0.0f) v = 0.0f;
-    if (v > 1.0f) v = 1.0f;
+    texture_level_get(&l, texture, level);
+    return texel_nearest(&l, u, v);
+}
 
-    int x = (int)(u * (texture->width - 1) + 0.5f);
-    int y = (int)(v * (texture->height - 1) + 0.5f);
+#ifdef SIMD_WIDTH
+static INLINE vi_t
+vf_floor_vi(vf_t a) {
+    vi_t t = vf_to_vi(a);
+    return vi_add(t, vf_as_vi(vf_gt(vi_to_vf(t), a)));
+}
 
-    if (x < 0) x = 0;
-    if (x >= (int)texture->width) x = texture->width - 1;
-    if (y < 0) y = 0;
-    if (y >= (int)texture->height) y = texture->height - 1;
+static void
+texel_nearest_v(const texture_level_t* l, const float* u, const float* v, uint32_t* out) {
+    int32_t xs[SIMD_WIDTH], ys[SIMD_WIDTH];
+    vf_t fu = vf_load(u), fv = vf_load(v);
+    int i;
+
+    if (l->wrap) {
+        vi_store(xs, vi_and(vf_floor_vi(vf_mul(fu, vf_set1((float)l->width))), vi_set1(l->mask_x)));
+        vi_store(ys, vi_and(vf_floor_vi(vf_mul(fv, vf_set1((float)l->height))), vi_set1(l->mask_y)));
+    } else {
+        vf_t zero = vf_set1(0.0f), one = vf_set1(1.0f), half = vf_set1(0.5f);
+        fu = vf_min(vf_max(fu, zero), one);
+        fv = vf_min(vf_max(fv, zero), one);
+        vi_store(xs, vf_to_vi(vf_add(vf_mul(fu, vf_set1((float)(l->width - 1))), half)));
+        vi_store(ys, vf_to_vi(vf_add(vf_mul(fv, vf_set1((float)(l->height - 1))), half)));
+    }
 
-    int index = y * texture->width + x;
-    const uint32_t* pixels = (const uint32_t*)texture->pixels;
+    for (i = 0; i < SIMD_WIDTH; i++) {
+        out[i] = l->pixels[texel_index(l, xs[i], ys[i])];
+    }
+}
+
+static void
+texel_bilinear_v(const texture_level_t* l, const float* u, const float* v, uint32_t* out) {
+    int32_t xs[SIMD_WIDTH], ys[SIMD_WIDTH], fx[SIMD_WIDTH], fy[SIMD_WIDTH];
+    uint32_t t[4][SIMD_WIDTH], w[4][SIMD_WIDTH];
+    vf_t fu = vf_sub(vf_mul(vf_load(u), vf_set1((float)l->width)), vf_set1(0.5f));
+    vf_t fv = vf_sub(vf_mul(vf_load(v), vf_set1((float)l->height)), vf_set1(0.5f));
+    int i, k;
+
+    if (!l->wrap) {
+        fu = vf_min(vf_max(fu, vf_set1(-1.0f)), vf_set1((float)l->width));
+        fv = vf_min(vf_max(fv, vf_set1(-1.0f)), vf_set1((float)l->height));
+    }
 
-    return pixels[index];
+    vi_t x0 = vf_floor_vi(fu), y0 = vf_floor_vi(fv);
+    vf_t scale = vf_set1(256.0f);
+    vi_store(xs, x0);
+    vi_store(ys, y0);
+    vi_store(fx, vf_to_vi(vf_mul(vf_sub(fu, vi_to_vf(x0)), scale)));
+    vi_store(fy, vf_to_vi(vf_mul(vf_sub(fv, vi_to_vf(y0)), scale)));
+
+    for (i = 0; i < SIMD_WIDTH; i++) {
+        uint32_t ti[4], wi[4];
+        texel_taps(l, xs[i], ys[i], ti);
+        texel_weights(fx[i], fy[i], wi);
+        for (k = 0; k < 4; k++) {
+            t[k][i] = ti[k];
+            w[k][i] = wi[k] | wi[k] << 16;
+        }
+    }
+
+    vi_t lo = vi_set1(0x00ff00ff);
+    vi_t rb = vi_set1(0), ag = vi_set1(0);
+    for (k = 0; k < 4; k++) {
+        vi_t tk = vi_load(t[k]), wk = vi_load(w[k]);
+        rb = vi_add(rb, vi_mul16(vi_and(tk, lo), wk));
+        ag = vi_add(ag, vi_mul16(vi_and(vi_srl(tk, 8), lo), wk));
+    }
+    vi_store(out, vi_or(vi_and(vi_srl(rb, 8), lo), vi_and(ag, vi_set1((int)0xff00ff00))));
+}
+#endif
+
+void
+asset_texture_sample(const asset_texture_t* texture, const float* u, const float* v,
+                     uint32_t* out, int count, uint32_t level, int filter) {
+    texture_level_t l;
+    int i = 0;
+
+    if (!texture || !texture->pixels) {
+        for (i = 0; i < count; i++) out[i] = 0xFFFFFFFF;
+        return;
+    }
+
+    texture_level_get(&l, texture, level);
+#ifdef SIMD_WIDTH
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        if (filter == TEXTURE_FILTER_BILINEAR) texel_bilinear_v(&l, u + i, v + i, out + i);
+        else texel_nearest_v(&l, u + i, v + i, out + i);
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = filter == TEXTURE_FILTER_BILINEAR ? texel_bilinear(&l, u[i], v[i]) : texel_nearest(&l, u[i], v[i]);
+    }
 }
\ No newline at end of file
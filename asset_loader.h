@@ -10,6 +10,14 @@
 #define CHUNK_AUDIO 0x49445541
 #define CHUNK_DONE 0x454E4F44
 
+#define TEXTURE_FORMAT_LINEAR 0
+#define TEXTURE_FORMAT_TILED 1
+#define TEXTURE_TILE_SIZE 4
+#define TEXTURE_MAX_LEVELS 16
+
+#define TEXTURE_FILTER_NEAREST 0
+#define TEXTURE_FILTER_BILINEAR 1
+
 typedef struct {
     uint32_t magic;
     uint32_t version;
@@ -27,6 +35,10 @@ typedef struct {
     uint32_t height;
     uint32_t format;
     const uint8_t* pixels;
+    uint32_t wrap_x;
+    uint32_t wrap_y;
+    uint32_t level_count;
+    const uint8_t* levels[TEXTURE_MAX_LEVELS];
 } asset_texture_t;
 
 typedef struct {
@@ -42,6 +54,7 @@ typedef struct {
     const uint32_t* colors;
     const float* uvs;
     const uint32_t* uv_indices;
+    const float* bounds;
 } asset_mesh_t;
 
 typedef struct {
@@ -63,5 +76,8 @@ asset_texture_t* asset_get_texture(asset_blob_t* blob, uint32_t index);
 asset_mesh_t* asset_get_mesh(asset_blob_t* blob, uint32_t index);
 mesh_t asset_mesh_to_mesh(const asset_mesh_t* asset_mesh);
 uint32_t asset_texture_get_color(const asset_texture_t* texture, float u, float v);
+uint32_t asset_texture_get_color_level(const asset_texture_t* texture, float u, float v, uint32_t level);
+uint32_t asset_texture_level(const asset_texture_t* texture, float uv_area);
+void asset_texture_sample(const asset_texture_t* texture, const float* u, const float* v, uint32_t* out, int count, uint32_t level, int filter);
 
 #endif
\ No newline at end of file
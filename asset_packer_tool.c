@@ -15,6 +15,11 @@
 #define CHUNK_AUDIO 0x49445541
 #define CHUNK_DONE 0x454E4F44
 
+#define TEXTURE_FORMAT_LINEAR 0
+#define TEXTURE_FORMAT_TILED 1
+#define TEXTURE_TILE_SIZE 4
+#define TEXTURE_MAX_LEVELS 16
+
 typedef struct {
     uint32_t magic;
     uint32_t version;
@@ -59,18 +64,73 @@ static void
 write_header(FILE* f, uint32_t chunk_count, uint32_t total_size) {
     asset_header_t header = {
         .magic = CHUNK_HEADER,
-        .version = 1,
+        .version = 3,
         .chunk_count = chunk_count,
         .total_size = total_size
     };
     fwrite(&header, sizeof(asset_header_t), 1, f);
 }
 
+static int
+level_size(int size, int level) {
+    return (size >> level) ? (size >> level) : 1;
+}
+
+static int
+level_count(loaded_texture_t* tex, int mips) {
+    int count = 1;
+    while (mips && count < TEXTURE_MAX_LEVELS && (tex->width >> count || tex->height >> count)) {
+        count++;
+    }
+    return count;
+}
+
+static void
+downsample(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh) {
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            int x0 = MIN(x * 2, sw - 1), x1 = MIN(x * 2 + 1, sw - 1);
+            int y0 = MIN(y * 2, sh - 1), y1 = MIN(y * 2 + 1, sh - 1);
+            for (int c = 0; c < 4; c++) {
+                int sum = src[(y0 * sw + x0) * 4 + c] + src[(y0 * sw + x1) * 4 + c] +
+                          src[(y1 * sw + x0) * 4 + c] + src[(y1 * sw + x1) * 4 + c];
+                dst[(y * dw + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+static void
+write_texture_level(FILE* f, const unsigned char* data, int width, int height, int tiled) {
+    if (tiled && !(width % TEXTURE_TILE_SIZE) && !(height % TEXTURE_TILE_SIZE)) {
+        for (int ty = 0; ty < height; ty += TEXTURE_TILE_SIZE) {
+            for (int tx = 0; tx < width; tx += TEXTURE_TILE_SIZE) {
+                for (int y = ty; y < ty + TEXTURE_TILE_SIZE; y++) {
+                    fwrite(data + ((size_t)y * width + tx) * 4, 4, TEXTURE_TILE_SIZE, f);
+                }
+            }
+        }
+    } else {
+        fwrite(data, 1, (size_t)width * height * 4, f);
+    }
+}
+
 static size_t
-write_texture_chunk(FILE* f, loaded_texture_t* tex) {
-    size_t pixel_data_size = tex->width * tex->height * 4;
+write_texture_chunk(FILE* f, loaded_texture_t* tex, int tiled, int mips) {
+    int levels = level_count(tex, mips);
+    size_t pixel_data_size = 0;
+
+    for (int i = 0; i < levels; i++) {
+        pixel_data_size += (size_t)level_size(tex->width, i) * level_size(tex->height, i) * 4;
+    }
     size_t chunk_size = sizeof(texture_data_t) + pixel_data_size;
 
+    if (tiled && (tex->width % TEXTURE_TILE_SIZE || tex->height % TEXTURE_TILE_SIZE)) {
+        printf("  WARNING: %s is not a multiple of %d texels, storing it linear\n",
+               tex->path, TEXTURE_TILE_SIZE);
+        tiled = 0;
+    }
+
     chunk_header_t chunk_hdr = {
         .chunk_id = CHUNK_TEXTURE,
         .chunk_size = chunk_size
@@ -80,14 +140,28 @@ write_texture_chunk(FILE* f, loaded_texture_t* tex) {
     texture_data_t tex_data = {
         .width = tex->width,
         .height = tex->height,
-        .format = 0
+        .format = tiled ? TEXTURE_FORMAT_TILED : TEXTURE_FORMAT_LINEAR
     };
     fwrite(&tex_data, sizeof(texture_data_t), 1, f);
 
-    fwrite(tex->data, 1, pixel_data_size, f);
+    write_texture_level(f, tex->data, tex->width, tex->height, tiled);
+
+    if (levels > 1) {
+        unsigned char* prev = tex->data;
+        unsigned char* level = NULL;
+        for (int i = 1; i < levels; i++) {
+            int w = level_size(tex->width, i), h = level_size(tex->height, i);
+            level = malloc((size_t)w * h * 4);
+            downsample(prev, level_size(tex->width, i - 1), level_size(tex->height, i - 1), level, w, h);
+            write_texture_level(f, level, w, h, tiled);
+            if (prev != tex->data) free(prev);
+            prev = level;
+        }
+        if (prev != tex->data) free(prev);
+    }
 
-    printf("  [TEXR] %s: %dx%d (%.2f KB)\n", 
-           tex->path, tex->width, tex->height, 
+    printf("  [TEXR] %s: %dx%d%s, %d levels (%.2f KB)\n", 
+           tex->path, tex->width, tex->height, tiled ? " tiled" : "", levels,
            (sizeof(chunk_header_t) + chunk_size) / 1024.0f);
 
     return sizeof(chunk_header_t) + chunk_size;
@@ -103,6 +177,7 @@ write_mesh_chunk(FILE* f, loaded_mesh_t* lmesh) {
     size_t color_size = da_size(mesh->colors) * sizeof(uint32_t);
     size_t uv_size = da_size(mesh->uvs) * sizeof(float);
     size_t uv_index_size = da_size(mesh->uv_indices) * sizeof(uint32_t);
+    size_t bounds_size = 6 * sizeof(float);
 
     size_t chunk_size = sizeof(mesh_data_t) + 
                        vertex_size + 
@@ -110,7 +185,8 @@ write_mesh_chunk(FILE* f, loaded_mesh_t* lmesh) {
                        normal_size + 
                        color_size + 
                        uv_size + 
-                       uv_index_size;
+                       uv_index_size +
+                       bounds_size;
 
     chunk_header_t chunk_hdr = {
         .chunk_id = CHUNK_MESH,
@@ -146,6 +222,8 @@ write_mesh_chunk(FILE* f, loaded_mesh_t* lmesh) {
     if (uv_index_size > 0) {
         fwrite(mesh->uv_indices->data, 1, uv_index_size, f);
     }
+    fwrite(&mesh->bounds_min, sizeof(float), 3, f);
+    fwrite(&mesh->bounds_max, sizeof(float), 3, f);
 
     printf("  [MESH] %s: v=%u i=%u (%.2f KB)\n", 
            lmesh->path, mesh_data.vertex_count, mesh_data.index_count,
@@ -224,7 +302,7 @@ int
 main(int argc, char** argv) {
     if (argc < 3) {
         printf("Asset Packer Tool v2.0\n");
-        printf("Usage: %s <output_name> <file1> <file2> ...\n", argv[0]);
+        printf("Usage: %s <output_name> [--tiled] [--mips] <file1> <file2> ...\n", argv[0]);
         printf("\nSupported formats:\n");
         printf("  Models:   .obj\n");
         printf("  Textures: .png .jpg .jpeg .bmp .tga .psd .gif .hdr .pic .pnm\n");
@@ -234,6 +312,8 @@ main(int argc, char** argv) {
         printf("  - game.assets (binary blob)\n");
         printf("  - game_assets.c (C array)\n");
         printf("\nAll textures will be packed first, then all meshes.\n");
+        printf("--tiled stores textures in 4x4 texel blocks for cache-friendly sampling.\n");
+        printf("--mips appends a box-filtered mip chain to every texture.\n");
         return 1;
     }
 
@@ -254,12 +334,24 @@ main(int argc, char** argv) {
     loaded_mesh_t meshes[64];
     int texture_count = 0;
     int mesh_count = 0;
+    int tiled = 0;
+    int mips = 0;
 
     printf("=== Phase 1: Loading Assets ===\n");
     
     for (int i = 2; i < argc; i++) {
         const char* filepath = argv[i];
         
+        if (strcmp(filepath, "--tiled") == 0) {
+            tiled = 1;
+            continue;
+        }
+
+        if (strcmp(filepath, "--mips") == 0) {
+            mips = 1;
+            continue;
+        }
+
         if (has_extension(filepath, ".obj")) {
             printf("Loading mesh: %s\n", filepath);
             if (mesh_count >= 64) {
@@ -337,7 +429,7 @@ main(int argc, char** argv) {
     if (texture_count > 0) {
         printf("\nTexture Chunks:\n");
         for (int i = 0; i < texture_count; i++) {
-            size_t written = write_texture_chunk(temp_file, &textures[i]);
+            size_t written = write_texture_chunk(temp_file, &textures[i], tiled, mips);
             total_size += written;
             chunk_count++;
         }
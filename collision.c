@@ -3,6 +3,7 @@
 #include <assert.h>
 
 static plane_t planes[FRUSTUM_COUNT];
+static plane_t guard_planes[FRUSTUM_NEAR];
 
 void
 init_planes(float fov_x, float fov_y, float znear, float zfar) {
@@ -40,6 +41,30 @@ init_planes(float fov_x, float fov_y, float znear, float zfar) {
 	planes[FRUSTUM_FAR].norm.x = 0;
 	planes[FRUSTUM_FAR].norm.y = 0;
 	planes[FRUSTUM_FAR].norm.z = -1;
+
+	int i;
+	for (i = 0; i < FRUSTUM_NEAR; i++) {
+		guard_planes[i] = planes[i];
+		guard_planes[i].norm.z *= CLIP_GUARD_BAND;
+	}
+}
+
+const plane_t*
+frustum_planes(void) {
+    return planes;
+}
+
+int
+point_outcode(vec3_t p) {
+    int code = 0;
+    int i;
+    for (i = 0; i < FRUSTUM_COUNT; i++) {
+        if (v3_dot(planes[i].norm, v3_sub(p, planes[i].point)) <= 0) code |= 1 << i;
+    }
+    for (i = 0; i < FRUSTUM_NEAR; i++) {
+        if (v3_dot(guard_planes[i].norm, p) <= 0) code |= 1 << (OUTCODE_GUARD_SHIFT + i);
+    }
+    return code;
 }
 
 polygon_t polygon_create(vec3_t v1, vec3_t v2, vec3_t v3, vec2_t uv1, vec2_t uv2, vec2_t uv3){
@@ -112,6 +137,14 @@ void polygon_clip(polygon_t* polygon) {
     polygon_clip_plane(polygon, FRUSTUM_FAR);
 }
 
+void
+polygon_clip_mask(polygon_t* polygon, int mask) {
+    int i;
+    for (i = 0; i < FRUSTUM_COUNT && polygon->vertices_count >= 3; i++) {
+        if (mask & (1 << i)) polygon_clip_plane(polygon, i);
+    }
+}
+
 intersect_t
 line_plane_intersect(plane_t plane, vec3_t p1, vec3_t p2) {
     float dp1 = v3_dot(plane.norm, v3_sub(plane.point, p1));
@@ -15,6 +15,12 @@ typedef enum {
 
 #define MAX_VERTICES_COUNT 10
 
+#define CLIP_GUARD_BAND 2.0f
+
+#define OUTCODE_GUARD_SHIFT FRUSTUM_COUNT
+#define OUTCODE_FRUSTUM ((1 << FRUSTUM_COUNT) - 1)
+#define OUTCODE_DEPTH ((1 << FRUSTUM_NEAR) | (1 << FRUSTUM_FAR))
+
 typedef struct {
     vec3_t point;
     vec3_t norm;
@@ -34,6 +40,9 @@ typedef struct {
 void init_planes(float fov_x, float fov_y, float znear, float zfar);
 polygon_t polygon_create(vec3_t v1, vec3_t v2, vec3_t v3, vec2_t uv1, vec2_t uv2, vec2_t uv3);
 void polygon_clip(polygon_t* polygon);
+void polygon_clip_mask(polygon_t* polygon, int mask);
+int point_outcode(vec3_t p);
+const plane_t* frustum_planes(void);
 void
 polygon_clip_plane(polygon_t* polygon,
                    int plane_kind);
@@ -41,9 +41,11 @@ struct {
 struct {
     vec3_t direction;
     float intensity;
+    float ambient;
 } direct_light = {
     vec3_down,
-    0.5
+    0.5,
+    0.3
 };
 
 static camera_t camera = camera_perspective_default;
@@ -81,6 +83,9 @@ static float ASPECT_RATIO = 1;
 static vec2_t WINDOW_ORIGIN = {0};
 static float TIME_ON_FRAME = 0;
 static float TIME_SCALE = 1.0;
+static int TEX_SPAN = 0;
+static int TEX_FILTER = TEXTURE_FILTER_NEAREST;
+static depth_format_t DEPTH_FORMAT = DEPTH_FORMAT_F32;
 
 static int mx, my, wx, wy;
 static double draw_time, update_time;
@@ -184,6 +189,9 @@ g_init(const char* path) {
 
     game_state.mesh_queue = nude_mesh_queue_create();
 
+    nude_threads_set(x_cpu_count());
+    n_light_set(direct_light.direction, direct_light.intensity, direct_light.ambient);
+
     return &game;
 }
 
@@ -202,6 +210,7 @@ g_term() {
     }
 
     nude_mesh_queue_destroy(game_state.mesh_queue);
+    nude_threads_set(1);
 }
 
 int activated = 0;
@@ -275,6 +284,41 @@ g_input(float dt) {
         n_flag_toggle(DRAW_FLAG_FULLRECT);
     }
 
+    if (input_get_key_down(KEY_CODE_8)) {
+        n_flag_toggle(DRAW_FLAG_BINNING);
+    }
+
+    if (input_get_key_down(KEY_CODE_9)) {
+        n_flag_toggle(DRAW_FLAG_SUBPIXEL);
+    }
+
+    if (input_get_key_down(KEY_CODE_0)) {
+        n_flag_toggle(DRAW_FLAG_VISBUFFER);
+    }
+
+    if (input_get_key_down(KEY_CODE_T)) {
+        TEX_SPAN = TEX_SPAN >= 16 ? 0 : MAX(TEX_SPAN * 2, 8);
+        n_tex_span_set(TEX_SPAN);
+    }
+
+    if (input_get_key_down(KEY_CODE_L)) {
+        n_flag_toggle(DRAW_FLAG_LAZYCLEAR);
+    }
+
+    if (input_get_key_down(KEY_CODE_B)) {
+        n_flag_toggle(DRAW_FLAG_TILEDFB);
+    }
+
+    if (input_get_key_down(KEY_CODE_F)) {
+        TEX_FILTER = TEX_FILTER == TEXTURE_FILTER_NEAREST ? TEXTURE_FILTER_BILINEAR : TEXTURE_FILTER_NEAREST;
+        n_tex_filter_set(TEX_FILTER);
+    }
+
+    if (input_get_key_down(KEY_CODE_Z)) {
+        DEPTH_FORMAT = DEPTH_FORMAT == DEPTH_FORMAT_UNORM16 ? DEPTH_FORMAT_F32 : DEPTH_FORMAT + 1;
+        n_depth_format_set(DEPTH_FORMAT);
+    }
+
     if (input_get_button(BUTTON_MOUSE_RIGHT)) {
         int x, y;
         input_get_mouse_pos(&x, &y);
@@ -356,6 +400,8 @@ g_update(float dt) {
     }
 
     draw_buttons();
+    n_clear_resolve(game.color, 0);
+    n_layout_resolve(game.color);
 
     /* END OF DRAW */
     draw_time = x_get_absolute_time() - start_frame;
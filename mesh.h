@@ -14,8 +14,59 @@ typedef struct {
     darray_t* uv_indices;
     mat4_t transform;
     const void* texture;
+    vec3_t bounds_min;
+    vec3_t bounds_max;
 } mesh_t;
 
+static INLINE void
+mesh_bounds_compute(mesh_t* mesh) {
+    const vec3_t* v = (const vec3_t*)mesh->vertices->data;
+    int count = (int)(da_size(mesh->vertices) / 3);
+    int i;
+
+    mesh->bounds_min = vec3_zero;
+    mesh->bounds_max = vec3_zero;
+    if (count == 0) return;
+
+    mesh->bounds_min = v[0];
+    mesh->bounds_max = v[0];
+    for (i = 1; i < count; i++) {
+        if (v[i].x < mesh->bounds_min.x) mesh->bounds_min.x = v[i].x;
+        if (v[i].y < mesh->bounds_min.y) mesh->bounds_min.y = v[i].y;
+        if (v[i].z < mesh->bounds_min.z) mesh->bounds_min.z = v[i].z;
+        if (v[i].x > mesh->bounds_max.x) mesh->bounds_max.x = v[i].x;
+        if (v[i].y > mesh->bounds_max.y) mesh->bounds_max.y = v[i].y;
+        if (v[i].z > mesh->bounds_max.z) mesh->bounds_max.z = v[i].z;
+    }
+}
+
+static INLINE void
+mesh_normals_compute(mesh_t* mesh) {
+    const vec3_t* v = (const vec3_t*)mesh->vertices->data;
+    const uint32_t* tri = (const uint32_t*)mesh->indices->data;
+    int count = (int)(da_size(mesh->vertices) / 3);
+    int faces = (int)(da_size(mesh->indices) / 3);
+    vec3_t* n;
+    int i;
+
+    if (!mesh->normals || count == 0) return;
+    da_resize(mesh->normals, count * 3);
+    n = (vec3_t*)mesh->normals->data;
+    for (i = 0; i < count; i++) n[i] = vec3_zero;
+
+    for (i = 0; i < faces; i++, tri += 3) {
+        vec3_t a = v[tri[0] - 1];
+        vec3_t f = v3_cross(v3_sub(v[tri[1] - 1], a), v3_sub(v[tri[2] - 1], a));
+        n[tri[0] - 1] = v3_add(n[tri[0] - 1], f);
+        n[tri[1] - 1] = v3_add(n[tri[1] - 1], f);
+        n[tri[2] - 1] = v3_add(n[tri[2] - 1], f);
+    }
+    for (i = 0; i < count; i++) {
+        float len = v3_length(n[i]);
+        if (len > 0.0f) n[i] = v3_scale(n[i], 1.0f / len);
+    }
+}
+
 mesh_t mesh_create_box(float width, float height, float depth);
 mesh_t mesh_obj_load(const char* file_path);
 
@@ -42,11 +42,14 @@ mesh_create_box(float width,
         da_create(sizeof(float)),
         da_create(sizeof(uint32_t)),
         mat4_identity,
-        NULL
+        NULL,
+        vec3_zero,
+        vec3_zero
     };
     da_resize(m.vertices, sizeof BOX_VERTICES / sizeof BOX_VERTICES[0]);
     da_resize(m.indices, sizeof BOX_INDICES / sizeof BOX_INDICES[0]);
     x_mem_copy(m.vertices->data, BOX_VERTICES, m.vertices->count * m.vertices->stride);
     x_mem_copy(m.indices->data, BOX_INDICES, m.indices->count * m.indices->stride);
+    mesh_bounds_compute(&m);
     return m;
 }
@@ -1,4 +1,5 @@
 #include "mm.h"
+#include "simd.h"
 
 #define LUT_SIZE 4096
 #define LUT_MASK (LUT_SIZE - 1)
@@ -172,9 +173,11 @@ float mm_fmod(float x, float y) {
     return r;
 }
 
-#define BIT_NOSIE1 0xB5297A4D;
-#define BIT_NOSIE2 0x68E31DA4;
-#define BIT_NOSIE3 0x1B56C4E9;
+#define BIT_NOSIE1 0xB5297A4D
+#define BIT_NOSIE2 0x68E31DA4
+#define BIT_NOSIE3 0x1B56C4E9
+#define NOISE_PRIME1 198491317
+#define NOISE_PRIME2 6542989
 
 uint32_t
 mm_rng(int32_t pos, uint32_t seed) {
@@ -197,17 +200,14 @@ mm_rng_range(int32_t min, int32_t max, int32_t pos, uint32_t seed) {
 
 uint32_t
 mm_rng_noise2d(int posX, int posY, uint32_t seed) {
-    int PRIME_NUMBER = 198491317;
-    return mm_rng(posX + (PRIME_NUMBER * posY), seed);
+    return mm_rng(posX + (NOISE_PRIME1 * posY), seed);
 }
 
 uint32_t
 mm_rng_noise3d(int posX, int posY, int posZ, uint32_t seed)
 {
-    int PRIME_NUMBER1 = 198491317;
-    int PRIME_NUMBER2 = 6542989;
-    return mm_rng(posX + (PRIME_NUMBER1 * posY)
-        + (PRIME_NUMBER2 * posZ), seed);
+    return mm_rng(posX + (NOISE_PRIME1 * posY)
+        + (NOISE_PRIME2 * posZ), seed);
 }
 
 uint32_t
@@ -293,3 +293,203 @@ float mm_noise3d(float x, float y, float z, uint32_t seed) {
 
     return lerp(iy0, iy1, sz);
 }
+
+static float
+fbm_norm(int octaves, float gain) {
+    float amp = 1.0f, norm = 0.0f;
+    int k;
+    for (k = 0; k < octaves; k++, amp *= gain) norm += amp;
+    return norm > 0.0f ? 1.0f / norm : 0.0f;
+}
+
+float mm_fbm2d(float x, float y, int octaves, float lacunarity, float gain, uint32_t seed) {
+    float amp = fbm_norm(octaves, gain), sum = 0.0f;
+    int k;
+    for (k = 0; k < octaves; k++) {
+        sum += mm_noise2d(x, y, seed + k) * amp;
+        x *= lacunarity;
+        y *= lacunarity;
+        amp *= gain;
+    }
+    return sum;
+}
+
+float mm_fbm3d(float x, float y, float z, int octaves, float lacunarity, float gain, uint32_t seed) {
+    float amp = fbm_norm(octaves, gain), sum = 0.0f;
+    int k;
+    for (k = 0; k < octaves; k++) {
+        sum += mm_noise3d(x, y, z, seed + k) * amp;
+        x *= lacunarity;
+        y *= lacunarity;
+        z *= lacunarity;
+        amp *= gain;
+    }
+    return sum;
+}
+
+#ifdef SIMD_WIDTH
+static INLINE vi_t
+rng_v(vi_t pos, vi_t seed) {
+    vi_t mangled = vi_mul(pos, vi_set1(BIT_NOSIE1));
+    mangled = vi_add(mangled, seed);
+    mangled = vi_xor(mangled, vi_srl(mangled, 8));
+    mangled = vi_add(mangled, vi_set1(BIT_NOSIE2));
+    mangled = vi_xor(mangled, vi_sll(mangled, 8));
+    mangled = vi_mul(mangled, vi_set1(BIT_NOSIE3));
+    mangled = vi_xor(mangled, vi_srl(mangled, 8));
+    return mangled;
+}
+
+static INLINE vf_t
+rng_float01_v(vi_t pos, vi_t seed) {
+    vi_t h = rng_v(pos, seed);
+    vf_t hi = vf_mul(vi_to_vf(vi_srl(h, 16)), vf_set1(65536.0f));
+    vf_t lo = vi_to_vf(vi_and(h, vi_set1(0xffff)));
+    return vf_div(vf_add(hi, lo), vf_set1(4294967295.0f));
+}
+
+static INLINE vf_t
+floor_v(vf_t x, vi_t* i) {
+    vi_t t = vf_to_vi(x);
+    vf_t up = vf_gt(vi_to_vf(t), x);
+    *i = vi_add(t, vf_as_vi(up));
+    return vf_sub(vi_to_vf(t), vf_and(up, vf_set1(1.0f)));
+}
+
+static INLINE vf_t
+smoothstep_v(vf_t t) {
+    return vf_mul(vf_mul(t, t), vf_sub(vf_set1(3.0f), vf_mul(vf_set1(2.0f), t)));
+}
+
+static INLINE vf_t
+lerp_v(vf_t from, vf_t to, vf_t t) {
+    return vf_add(from, vf_mul(t, vf_sub(to, from)));
+}
+
+static INLINE vf_t
+noise2d_v(vf_t x, vf_t y, vi_t seed) {
+    vi_t x0, y0, one = vi_set1(1);
+    vf_t sx = smoothstep_v(vf_sub(x, floor_v(x, &x0)));
+    vf_t sy = smoothstep_v(vf_sub(y, floor_v(y, &y0)));
+    vi_t p0 = vi_add(x0, vi_mul(y0, vi_set1(NOISE_PRIME1)));
+    vi_t p1 = vi_add(p0, vi_set1(NOISE_PRIME1));
+
+    vf_t ix0 = lerp_v(rng_float01_v(p0, seed), rng_float01_v(vi_add(p0, one), seed), sx);
+    vf_t ix1 = lerp_v(rng_float01_v(p1, seed), rng_float01_v(vi_add(p1, one), seed), sx);
+    return lerp_v(ix0, ix1, sy);
+}
+
+static INLINE vf_t
+noise3d_v(vf_t x, vf_t y, vf_t z, vi_t seed) {
+    vi_t x0, y0, z0, one = vi_set1(1);
+    vf_t sx = smoothstep_v(vf_sub(x, floor_v(x, &x0)));
+    vf_t sy = smoothstep_v(vf_sub(y, floor_v(y, &y0)));
+    vf_t sz = smoothstep_v(vf_sub(z, floor_v(z, &z0)));
+    vi_t p00 = vi_add(vi_add(x0, vi_mul(y0, vi_set1(NOISE_PRIME1))), vi_mul(z0, vi_set1(NOISE_PRIME2)));
+    vi_t p10 = vi_add(p00, vi_set1(NOISE_PRIME1));
+    vi_t p01 = vi_add(p00, vi_set1(NOISE_PRIME2));
+    vi_t p11 = vi_add(p10, vi_set1(NOISE_PRIME2));
+
+    vf_t ix00 = lerp_v(rng_float01_v(p00, seed), rng_float01_v(vi_add(p00, one), seed), sx);
+    vf_t ix10 = lerp_v(rng_float01_v(p10, seed), rng_float01_v(vi_add(p10, one), seed), sx);
+    vf_t ix01 = lerp_v(rng_float01_v(p01, seed), rng_float01_v(vi_add(p01, one), seed), sx);
+    vf_t ix11 = lerp_v(rng_float01_v(p11, seed), rng_float01_v(vi_add(p11, one), seed), sx);
+
+    vf_t iy0 = lerp_v(ix00, ix10, sy);
+    vf_t iy1 = lerp_v(ix01, ix11, sy);
+    return lerp_v(iy0, iy1, sz);
+}
+#endif
+
+static void
+noise2d_row(float* out, float x, float y, float step, int count, uint32_t seed, float amp, int add) {
+    int i = 0;
+#ifdef SIMD_WIDTH
+    vf_t vy = vf_set1(y), va = vf_set1(amp);
+    vi_t vs = vi_set1(seed);
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        vf_t vx = vf_add(vf_set1(x), vf_mul(vf_add(vf_set1(i), vf_ramp()), vf_set1(step)));
+        vf_t n = vf_mul(noise2d_v(vx, vy, vs), va);
+        vf_store(out + i, add ? vf_add(vf_load(out + i), n) : n);
+    }
+#endif
+    for (; i < count; i++) {
+        float n = mm_noise2d(x + i * step, y, seed) * amp;
+        out[i] = add ? out[i] + n : n;
+    }
+}
+
+static void
+noise3d_row(float* out, float x, float y, float z, float step, int count, uint32_t seed, float amp, int add) {
+    int i = 0;
+#ifdef SIMD_WIDTH
+    vf_t vy = vf_set1(y), vz = vf_set1(z), va = vf_set1(amp);
+    vi_t vs = vi_set1(seed);
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        vf_t vx = vf_add(vf_set1(x), vf_mul(vf_add(vf_set1(i), vf_ramp()), vf_set1(step)));
+        vf_t n = vf_mul(noise3d_v(vx, vy, vz, vs), va);
+        vf_store(out + i, add ? vf_add(vf_load(out + i), n) : n);
+    }
+#endif
+    for (; i < count; i++) {
+        float n = mm_noise3d(x + i * step, y, z, seed) * amp;
+        out[i] = add ? out[i] + n : n;
+    }
+}
+
+static void
+noise2d_grid(float* out, float x, float y, float step, int count_x, int count_y,
+             uint32_t seed, float amp, int add) {
+    int j;
+    for (j = 0; j < count_y; j++) {
+        noise2d_row(out + j * count_x, x, y + j * step, step, count_x, seed, amp, add);
+    }
+}
+
+static void
+noise3d_grid(float* out, float x, float y, float z, float step, int count_x, int count_y, int count_z,
+             uint32_t seed, float amp, int add) {
+    int j, k;
+    for (k = 0; k < count_z; k++) {
+        for (j = 0; j < count_y; j++) {
+            noise3d_row(out + (k * count_y + j) * count_x, x, y + j * step, z + k * step, step, count_x, seed, amp, add);
+        }
+    }
+}
+
+void mm_noise2d_batch(float* out, float x, float y, float step, int count_x, int count_y, uint32_t seed) {
+    noise2d_grid(out, x, y, step, count_x, count_y, seed, 1.0f, 0);
+}
+
+void mm_noise3d_batch(float* out, float x, float y, float z, float step,
+                      int count_x, int count_y, int count_z, uint32_t seed) {
+    noise3d_grid(out, x, y, z, step, count_x, count_y, count_z, seed, 1.0f, 0);
+}
+
+void mm_fbm2d_batch(float* out, float x, float y, float step, int count_x, int count_y,
+                    int octaves, float lacunarity, float gain, uint32_t seed) {
+    float amp = fbm_norm(octaves, gain);
+    int k;
+    for (k = 0; k < octaves; k++) {
+        noise2d_grid(out, x, y, step, count_x, count_y, seed + k, amp, k > 0);
+        x *= lacunarity;
+        y *= lacunarity;
+        step *= lacunarity;
+        amp *= gain;
+    }
+}
+
+void mm_fbm3d_batch(float* out, float x, float y, float z, float step,
+                    int count_x, int count_y, int count_z,
+                    int octaves, float lacunarity, float gain, uint32_t seed) {
+    float amp = fbm_norm(octaves, gain);
+    int k;
+    for (k = 0; k < octaves; k++) {
+        noise3d_grid(out, x, y, z, step, count_x, count_y, count_z, seed + k, amp, k > 0);
+        x *= lacunarity;
+        y *= lacunarity;
+        z *= lacunarity;
+        step *= lacunarity;
+        amp *= gain;
+    }
+}
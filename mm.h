@@ -119,6 +119,17 @@ float mm_rng_noise2d_f(int posX, int posY, uint32_t seed);
 float mm_rng_noise3d_f(int posX, int posY, int posZ, uint32_t seed);
 float mm_noise2d(float x, float y, uint32_t seed);
 float mm_noise3d(float x, float y, float z, uint32_t seed);
+float mm_fbm2d(float x, float y, int octaves, float lacunarity, float gain, uint32_t seed);
+float mm_fbm3d(float x, float y, float z, int octaves, float lacunarity, float gain, uint32_t seed);
+
+void mm_noise2d_batch(float* out, float x, float y, float step, int count_x, int count_y, uint32_t seed);
+void mm_noise3d_batch(float* out, float x, float y, float z, float step,
+                      int count_x, int count_y, int count_z, uint32_t seed);
+void mm_fbm2d_batch(float* out, float x, float y, float step, int count_x, int count_y,
+                    int octaves, float lacunarity, float gain, uint32_t seed);
+void mm_fbm3d_batch(float* out, float x, float y, float z, float step,
+                    int count_x, int count_y, int count_z,
+                    int octaves, float lacunarity, float gain, uint32_t seed);
 
 static INLINE vec2_t v2_add(vec2_t a, vec2_t b) {
     return (vec2_t) {{ a.x + b.x, a.y + b.y }};
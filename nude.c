@@ -1,10 +1,29 @@
 #include "nude.h"
 #include "collision.h"
 #include "mm.h"
+#include "simd.h"
 #include "texture.h"
 #include "xeno.h"
 #include <stdint.h>
 
+#define N_TILE_SIZE 64
+#define N_HIZ_SIZE 8
+#define N_FB_TILE 8
+#define N_SUBPIXEL_BITS 4
+#define N_SUBPIXEL_ONE (1 << N_SUBPIXEL_BITS)
+#define N_TRI_SMALL 9
+#define N_TRI_LARGE 32
+
+#if defined(_MSC_VER)
+#define N_KERNEL static __forceinline
+#elif defined(__GNUC__)
+#define N_KERNEL static __inline__ __attribute__((always_inline))
+#else
+#define N_KERNEL static INLINE
+#endif
+
+#define N_KERNEL_KEY(f) (((f) & 7) | (((f) & DRAW_FLAG_FULLRECT) >> 3) | (((f) & DRAW_FLAG_SUBPIXEL) >> 4))
+
 static drawing_flags_t flags = DRAW_FLAG_SHADE | DRAW_FLAG_CULLING | DRAW_FLAG_BACKFACE;
 
 static struct {
@@ -14,6 +33,11 @@ static struct {
     int ox;
     int oy;
     float aspect;
+    int tex_span;
+    int tex_filter;
+    depth_format_t depth_format;
+    depth_format_t depth_format_next;
+    int fb_tiled;
     mat4_t view;
     mat4_t proj;
 } ctx = {
@@ -23,6 +47,225 @@ static struct {
     1
 };
 
+static INLINE int
+fb_row(int y, const int tiled) {
+    return tiled ? (y & ~(N_FB_TILE - 1)) * ctx.width + (y & (N_FB_TILE - 1)) * N_FB_TILE : y * ctx.width;
+}
+
+static INLINE int
+fb_col(int x, const int tiled) {
+    return tiled ? (x & ~(N_FB_TILE - 1)) * N_FB_TILE + (x & (N_FB_TILE - 1)) : x;
+}
+
+static INLINE int
+fb_index(int x, int y) {
+    return fb_row(y, ctx.fb_tiled) + fb_col(x, ctx.fb_tiled);
+}
+
+typedef struct {
+    uint32_t* color;
+    void* depth;
+    int x0, y0;
+    int x1, y1;
+} target_t;
+
+static struct {
+    void* depth;
+    float* zmin;
+    int width, height;
+    int w, h;
+    int capacity;
+} hiz;
+
+#define N_LAZY_COLOR 1
+#define N_LAZY_DEPTH 2
+
+static struct {
+    uint32_t* color;
+    void* depth;
+    uint8_t* pending;
+    int tiles_x, tiles_y;
+    int capacity;
+    int active;
+} lazy;
+
+static void
+fill_color(uint32_t* dst, uint32_t value, int count, int stream) {
+    int i = 0;
+#ifdef SIMD_WIDTH
+    vi_t v = vi_set1((int)value);
+    if (stream) {
+        for (; i < count && ((uintptr_t)(dst + i) & (SIMD_WIDTH * 4 - 1)); i++) dst[i] = value;
+        for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vi_stream(dst + i, v);
+        simd_fence();
+    }
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vi_store(dst + i, v);
+#endif
+    for (; i < count; i++) dst[i] = value;
+}
+
+static INLINE int
+depth_size(const int format) {
+    return format == DEPTH_FORMAT_UNORM16 ? 2 : 4;
+}
+
+static INLINE float
+depth_max(const int format) {
+    return format == DEPTH_FORMAT_UNORM16 ? 65535.0f :
+           format == DEPTH_FORMAT_UNORM24 ? 16777215.0f : 1.0f;
+}
+
+static INLINE void*
+depth_ptr(void* depth, int offset, const int format) {
+    return (uint8_t*)depth + (size_t)offset * depth_size(format);
+}
+
+static INLINE float
+depth_quantize(float z, const int format) {
+    if (format == DEPTH_FORMAT_F32) return z;
+    return (float)(int32_t)(MIN(MAX(z, 0.0f), depth_max(format)) + 0.5f);
+}
+
+static INLINE float
+depth_load(const void* row, int x, const int format) {
+    if (format == DEPTH_FORMAT_UNORM24) return (float)((const uint32_t*)row)[x];
+    if (format == DEPTH_FORMAT_UNORM16) return (float)((const uint16_t*)row)[x];
+    return ((const float*)row)[x];
+}
+
+static INLINE void
+depth_store(void* row, int x, float z, const int format) {
+    if (format == DEPTH_FORMAT_UNORM24) ((uint32_t*)row)[x] = (uint32_t)z;
+    else if (format == DEPTH_FORMAT_UNORM16) ((uint16_t*)row)[x] = (uint16_t)z;
+    else ((float*)row)[x] = z;
+}
+
+#ifdef SIMD_WIDTH
+static INLINE vf_t
+depth_quantize_v(vf_t z, const int format) {
+    if (format == DEPTH_FORMAT_F32) return z;
+    z = vf_min(vf_max(z, vf_set1(0.0f)), vf_set1(depth_max(format)));
+    return vi_to_vf(vf_to_vi(vf_add(z, vf_set1(0.5f))));
+}
+
+static INLINE vf_t
+depth_load_v(const void* row, int x, const int format) {
+    if (format == DEPTH_FORMAT_UNORM24) return vi_to_vf(vi_load((const uint32_t*)row + x));
+    if (format == DEPTH_FORMAT_UNORM16) return vi_to_vf(vi_load_u16((const uint16_t*)row + x));
+    return vf_load((const float*)row + x);
+}
+
+static INLINE void
+depth_store_v(void* row, int x, vf_t z, const int format) {
+    if (format == DEPTH_FORMAT_UNORM24) vi_store((uint32_t*)row + x, vf_to_vi(z));
+    else if (format == DEPTH_FORMAT_UNORM16) vi_store_u16((uint16_t*)row + x, vf_to_vi(z));
+    else vf_store((float*)row + x, z);
+}
+#endif
+
+#define N_DEPTH_DISPATCH(kernel, ...) \
+    switch (ctx.depth_format) { \
+    case DEPTH_FORMAT_UNORM24: kernel(__VA_ARGS__, DEPTH_FORMAT_UNORM24); break; \
+    case DEPTH_FORMAT_UNORM16: kernel(__VA_ARGS__, DEPTH_FORMAT_UNORM16); break; \
+    default: kernel(__VA_ARGS__, DEPTH_FORMAT_F32); break; \
+    }
+
+#define N_TARGET_DISPATCH(kernel, ...) \
+    if (ctx.fb_tiled) { \
+        N_DEPTH_DISPATCH(kernel, __VA_ARGS__, 1) \
+    } else { \
+        N_DEPTH_DISPATCH(kernel, __VA_ARGS__, 0) \
+    }
+
+static void
+fill_depth(void* dst, int count, int stream) {
+    if (ctx.depth_format == DEPTH_FORMAT_UNORM24) {
+        fill_color(dst, 0, count, stream);
+    } else if (ctx.depth_format == DEPTH_FORMAT_UNORM16) {
+        uint16_t* d = dst;
+        if (count > 0 && ((uintptr_t)d & 2)) {
+            *d++ = 0;
+            count--;
+        }
+        fill_color((uint32_t*)d, 0, count / 2, stream);
+        if (count & 1) d[count - 1] = 0;
+    } else {
+        float* d = dst;
+        const float value = -3.402823466e+38f;
+        int i = 0;
+#ifdef SIMD_WIDTH
+        vf_t v = vf_set1(value);
+        if (stream) {
+            for (; i < count && ((uintptr_t)(d + i) & (SIMD_WIDTH * 4 - 1)); i++) d[i] = value;
+            for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vf_stream(d + i, v);
+            simd_fence();
+        }
+        for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vf_store(d + i, v);
+#endif
+        for (; i < count; i++) d[i] = value;
+    }
+}
+
+static void
+lazy_begin(uint32_t* color, void* depth) {
+    int count;
+    lazy.color = color;
+    lazy.depth = depth;
+    lazy.tiles_x = (ctx.width + N_TILE_SIZE - 1) / N_TILE_SIZE;
+    lazy.tiles_y = (ctx.height + N_TILE_SIZE - 1) / N_TILE_SIZE;
+    count = lazy.tiles_x * lazy.tiles_y;
+
+    if (count > lazy.capacity) {
+        lazy.pending = lazy.pending ? x_realloc(lazy.pending, count, 0) : x_alloc(count, 0);
+        lazy.capacity = count;
+    }
+    x_mem_set(lazy.pending, N_LAZY_COLOR | (depth ? N_LAZY_DEPTH : 0), count);
+    lazy.active = 1;
+}
+
+static void
+lazy_resolve(const uint32_t* color, const void* depth, int x0, int y0, int x1, int y1) {
+    int bits = (color && color == lazy.color ? N_LAZY_COLOR : 0) |
+               (depth && depth == lazy.depth ? N_LAZY_DEPTH : 0);
+    int band = ctx.fb_tiled ? N_FB_TILE : 1;
+    int tx, ty, y;
+
+    x0 = MAX(x0, 0);
+    y0 = MAX(y0, 0);
+    x1 = MIN(x1, ctx.width - 1);
+    y1 = MIN(y1, ctx.height - 1);
+    if (!bits || x0 > x1 || y0 > y1) return;
+
+    for (ty = y0 / N_TILE_SIZE; ty <= y1 / N_TILE_SIZE; ty++) {
+        for (tx = x0 / N_TILE_SIZE; tx <= x1 / N_TILE_SIZE; tx++) {
+            uint8_t* pending = &lazy.pending[ty * lazy.tiles_x + tx];
+            int fill = *pending & bits;
+            if (!fill) continue;
+
+            int sx = tx * N_TILE_SIZE;
+            int sy = ty * N_TILE_SIZE;
+            int w = MIN(N_TILE_SIZE, ctx.width - sx);
+            int ey = MIN(sy + N_TILE_SIZE, ctx.height);
+            for (y = sy; y < ey; y += band) {
+                if (fill & N_LAZY_COLOR) fill_color(lazy.color + fb_index(sx, y), ctx.clear_color, w * band, 0);
+                if (fill & N_LAZY_DEPTH) fill_depth(depth_ptr(lazy.depth, fb_index(sx, y), ctx.depth_format), w * band, 0);
+            }
+            *pending &= ~fill;
+        }
+    }
+}
+
+static INLINE void
+lazy_touch(const uint32_t* color, const void* depth, int x0, int y0, int x1, int y1) {
+    if (lazy.active) lazy_resolve(color, depth, x0, y0, x1, y1);
+}
+
+static target_t
+target_full(uint32_t* color, void* depth) {
+    target_t tg = { color, depth, 0, 0, ctx.width - 1, ctx.height - 1 };
+    return tg;
+}
+
 void n_ctx_view_set(mat4_t mat) {
     ctx.view = mat;
 }
@@ -42,6 +285,411 @@ top_left(float dx,
     return (dy > 0) || (dy == 0 && dx > 0);
 }
 
+typedef struct {
+    float w;
+    float dx;
+    float dy;
+    int top_left;
+} edge_t;
+
+typedef struct {
+    edge_t e[3];
+    float inv_area;
+    float zbias, z1, z2, z3;
+    float zmin, zmax;
+    int xmin, ymin, xmax, ymax;
+} tri_setup_t;
+
+static void
+edge_setup(edge_t* e, float ax, float ay, float bx, float by, float px, float py, int tl) {
+    e->w = edge_function_bar(ax, ay, bx, by, px, py);
+    e->dx = by - ay;
+    e->dy = ax - bx;
+    e->top_left = tl;
+}
+
+static INLINE int
+edge_inside(float w, const edge_t* e) {
+    return w > 0 || (w == 0 && e->top_left);
+}
+
+typedef struct {
+    float limit;
+    int tie;
+} edge_wire_t;
+
+static void
+edge_wire_setup(edge_wire_t* ew, const edge_t* e) {
+    ew->limit = 0.5f * MAX(mm_abs(e->dx), mm_abs(e->dy));
+    ew->tie = e->dx > 0 || (e->dx == 0 && e->dy > 0);
+}
+
+static INLINE int
+edge_wire_near(float w, const edge_wire_t* ew) {
+    return w < ew->limit || (w == ew->limit && ew->tie);
+}
+
+static INLINE uint32_t
+edge_wire_pick(const edge_wire_t* ew, const uint32_t* wire, float a, float b, float g, uint32_t fill) {
+    if (edge_wire_near(a, &ew[0])) return wire[0];
+    if (edge_wire_near(b, &ew[1])) return wire[1];
+    if (edge_wire_near(g, &ew[2])) return wire[2];
+    return fill;
+}
+
+#ifdef SIMD_WIDTH
+typedef struct {
+    vf_t step;
+    vf_t top_left;
+} edge_v_t;
+
+static void
+edge_v_setup(edge_v_t* ev, const edge_t* e) {
+    vf_t zero = vf_set1(0);
+    ev->step = vf_mul(vf_ramp(), vf_set1(e->dx));
+    ev->top_left = e->top_left ? vf_eq(zero, zero) : zero;
+}
+
+static INLINE vf_t
+edge_inside_v(vf_t w, const edge_v_t* ev) {
+    vf_t zero = vf_set1(0);
+    return vf_or(vf_gt(w, zero), vf_and(vf_eq(w, zero), ev->top_left));
+}
+
+static INLINE vf_t
+edge_wire_near_v(vf_t w, const edge_wire_t* ew) {
+    vf_t limit = vf_set1(ew->limit);
+    vf_t near = vf_gt(limit, w);
+    return ew->tie ? vf_or(near, vf_eq(limit, w)) : near;
+}
+
+static INLINE vi_t
+edge_wire_pick_v(const edge_wire_t* ew, const uint32_t* wire, vf_t a, vf_t b, vf_t g, vi_t fill) {
+    fill = vi_select(edge_wire_near_v(g, &ew[2]), vi_set1(wire[2]), fill);
+    fill = vi_select(edge_wire_near_v(b, &ew[1]), vi_set1(wire[1]), fill);
+    return vi_select(edge_wire_near_v(a, &ew[0]), vi_set1(wire[0]), fill);
+}
+#endif
+
+static void
+depth_setup(float* zbias, float* zmin, float* zmax, float z1, float z2, float z3) {
+    float eps = (0.5f + mm_abs(z1) + mm_abs(z2) + mm_abs(z3)) * 1e-6f;
+    if (ctx.depth_format == DEPTH_FORMAT_F32) {
+        *zbias = 0.5f;
+        *zmin = 0.5f + MIN(MIN(z1, z2), z3) - eps;
+        *zmax = 0.5f + MAX(MAX(z1, z2), z3) + eps;
+    } else {
+        float m = depth_max(ctx.depth_format);
+        float lo = (1.0f + MIN(MIN(z1, z2), z3) - eps) * m - 1.0f;
+        float hi = (1.0f + MAX(MAX(z1, z2), z3) + eps) * m + 1.0f;
+        *zbias = m;
+        *zmin = MIN(MAX(lo, 0.0f), m);
+        *zmax = MIN(MAX(hi, 0.0f), m);
+    }
+}
+
+static int
+tri_setup(tri_setup_t* t, const target_t* tg,
+          int x1, int y1, float z1,
+          int x2, int y2, float z2,
+          int x3, int y3, float z3) {
+    float area = edge_function_bar(x1, y1, x2, y2, x3, y3);
+    if (area == 0.0f) return 0;
+
+    t->xmin = MAX(MIN(MIN(x1, x2), x3), tg->x0);
+    t->xmax = MIN(MAX(MAX(x1, x2), x3), tg->x1);
+    t->ymin = MAX(MIN(MIN(y1, y2), y3), tg->y0);
+    t->ymax = MIN(MAX(MAX(y1, y2), y3), tg->y1);
+    if (t->xmin > t->xmax || t->ymin > t->ymax) return 0;
+
+    float px = t->xmin + 0.5f;
+    float py = t->ymin + 0.5f;
+
+    edge_setup(&t->e[0], x2, y2, x3, y3, px, py, top_left(x2 - x1, y2 - y1));
+    edge_setup(&t->e[1], x3, y3, x1, y1, px, py, top_left(x3 - x2, y3 - y2));
+    edge_setup(&t->e[2], x1, y1, x2, y2, px, py, top_left(x1 - x3, y1 - y3));
+
+    t->inv_area = 1.0f / area;
+    depth_setup(&t->zbias, &t->zmin, &t->zmax, z1, z2, z3);
+    t->z1 = z1 * t->inv_area * depth_max(ctx.depth_format);
+    t->z2 = z2 * t->inv_area * depth_max(ctx.depth_format);
+    t->z3 = z3 * t->inv_area * depth_max(ctx.depth_format);
+    lazy_touch(tg->color, tg->depth, t->xmin, t->ymin, t->xmax, t->ymax);
+    return 1;
+}
+
+typedef struct {
+    float w;
+    float dx;
+    float dy;
+    float ox, oy;
+} plane_eq_t;
+
+static void
+plane_eq_setup(plane_eq_t* p, const tri_setup_t* t, int x1, int y1, float q1, float q2, float q3) {
+    p->w = q1;
+    p->dx = (t->e[0].dx * q1 + t->e[1].dx * q2 + t->e[2].dx * q3) * t->inv_area;
+    p->dy = (t->e[0].dy * q1 + t->e[1].dy * q2 + t->e[2].dy * q3) * t->inv_area;
+    p->ox = x1 - 0.5f;
+    p->oy = y1 - 0.5f;
+}
+
+static INLINE float
+plane_eq_row(const plane_eq_t* p, int y) {
+    return p->w + (y - p->oy) * p->dy;
+}
+
+typedef struct {
+    float inv_area;
+    float w[3];
+    float uw[3], vw[3];
+} tex_persp_t;
+
+static void
+tex_persp_setup(tex_persp_t* p, float inv_area,
+                float w1, float u1, float v1,
+                float w2, float u2, float v2,
+                float w3, float u3, float v3) {
+    p->inv_area = inv_area;
+    p->w[0] = w1;
+    p->w[1] = w2;
+    p->w[2] = w3;
+    p->uw[0] = u1 / w1;
+    p->uw[1] = u2 / w2;
+    p->uw[2] = u3 / w3;
+    p->vw[0] = v1 / w1;
+    p->vw[1] = v2 / w2;
+    p->vw[2] = v3 / w3;
+}
+
+static INLINE void
+tex_persp(const tex_persp_t* p, float a, float b, float g, float* u, float* v) {
+    float la = a * p->inv_area;
+    float lb = b * p->inv_area;
+    float lg = g * p->inv_area;
+    float rw = la / p->w[0] + lb / p->w[1] + lg / p->w[2];
+    *u = (p->uw[0] * la + p->uw[1] * lb + p->uw[2] * lg) / rw;
+    *v = (p->vw[0] * la + p->vw[1] * lb + p->vw[2] * lg) / rw;
+}
+
+#ifdef SIMD_WIDTH
+static INLINE void
+tex_persp_v(const tex_persp_t* p, vf_t a, vf_t b, vf_t g, vf_t mask, float* us, float* vs) {
+    vf_t la = vf_mul(a, vf_set1(p->inv_area));
+    vf_t lb = vf_mul(b, vf_set1(p->inv_area));
+    vf_t lg = vf_mul(g, vf_set1(p->inv_area));
+    vf_t rw = vf_add(vf_add(vf_div(la, vf_set1(p->w[0])), vf_div(lb, vf_set1(p->w[1]))), vf_div(lg, vf_set1(p->w[2])));
+    vf_t u = vf_add(vf_add(vf_mul(vf_set1(p->uw[0]), la), vf_mul(vf_set1(p->uw[1]), lb)), vf_mul(vf_set1(p->uw[2]), lg));
+    vf_t v = vf_add(vf_add(vf_mul(vf_set1(p->vw[0]), la), vf_mul(vf_set1(p->vw[1]), lb)), vf_mul(vf_set1(p->vw[2]), lg));
+    vf_store(us, vf_and(vf_div(u, rw), mask));
+    vf_store(vs, vf_and(vf_div(v, rw), mask));
+}
+#endif
+
+static uint32_t
+tex_level(const void* texture, float inv_area,
+          float u1, float v1, float u2, float v2, float u3, float v3) {
+    float uv = ((u2 - u1) * (v3 - v1) - (u3 - u1) * (v2 - v1)) * inv_area;
+    return texture_level_from_asset((const struct asset_texture_t*)texture, mm_abs(uv));
+}
+
+typedef struct {
+    int x;
+    float u, v;
+    float du, dv;
+    float end, end_u, end_v;
+    float l, r;
+    float inv_len;
+    float inv_dx[3];
+} tex_span_t;
+
+static void
+tex_span_begin(tex_span_t* s, const tri_setup_t* t, int len) {
+    int i;
+    s->inv_len = 1.0f / len;
+    for (i = 0; i < 3; i++) {
+        s->inv_dx[i] = t->e[i].dx != 0 ? 1.0f / t->e[i].dx : 0;
+    }
+}
+
+static INLINE void
+tex_span_clamp(tex_span_t* s, const edge_t* e, float inv_dx, float w0) {
+    float x = -w0 * inv_dx;
+    if (e->dx > 0) s->l = MAX(s->l, x);
+    if (e->dx < 0) s->r = MIN(s->r, x);
+}
+
+static INLINE void
+tex_span_row(tex_span_t* s, const tri_setup_t* t, float a, float b, float g) {
+    s->x = -1;
+    s->end = -1;
+    s->l = -3.402823466e+38f;
+    s->r = 3.402823466e+38f;
+    tex_span_clamp(s, &t->e[0], s->inv_dx[0], a - t->xmin * t->e[0].dx);
+    tex_span_clamp(s, &t->e[1], s->inv_dx[1], b - t->xmin * t->e[1].dx);
+    tex_span_clamp(s, &t->e[2], s->inv_dx[2], g - t->xmin * t->e[2].dx);
+}
+
+static void
+tex_span_setup(tex_span_t* s, int sx, int len,
+               const plane_eq_t* pr, const plane_eq_t* pu, const plane_eq_t* pv,
+               float qr, float qu, float qv) {
+    float a0 = MAX((float)sx, s->l);
+    float a1 = MIN((float)(sx + len), s->r);
+    float u0, v0;
+
+    if (a0 == s->end) {
+        u0 = s->end_u;
+        v0 = s->end_v;
+    } else {
+        float d0 = a0 - pr->ox;
+        float w0 = 1.0f / (qr + d0 * pr->dx);
+        u0 = (qu + d0 * pu->dx) * w0;
+        v0 = (qv + d0 * pv->dx) * w0;
+    }
+
+    s->x = sx;
+    s->du = 0;
+    s->dv = 0;
+    s->end = -1;
+    if (a1 > a0) {
+        float d1 = a1 - pr->ox;
+        float w1 = 1.0f / (qr + d1 * pr->dx);
+        float k = a1 - a0 == len ? s->inv_len : 1.0f / (a1 - a0);
+        s->end = a1;
+        s->end_u = (qu + d1 * pu->dx) * w1;
+        s->end_v = (qv + d1 * pv->dx) * w1;
+        s->du = (s->end_u - u0) * k;
+        s->dv = (s->end_v - v0) * k;
+    }
+    s->u = u0 + (sx - a0) * s->du;
+    s->v = v0 + (sx - a0) * s->dv;
+}
+
+static INLINE int
+tri_covers(const tri_setup_t* t, int x, int y) {
+    float a = t->e[0].w + (x - t->xmin) * t->e[0].dx + (y - t->ymin) * t->e[0].dy;
+    float b = t->e[1].w + (x - t->xmin) * t->e[1].dx + (y - t->ymin) * t->e[1].dy;
+    float g = t->e[2].w + (x - t->xmin) * t->e[2].dx + (y - t->ymin) * t->e[2].dy;
+    return edge_inside(a, &t->e[0]) && edge_inside(b, &t->e[1]) && edge_inside(g, &t->e[2]);
+}
+
+typedef struct {
+    int count;
+    int x[N_TRI_SMALL], y[N_TRI_SMALL];
+    float a[N_TRI_SMALL], b[N_TRI_SMALL], g[N_TRI_SMALL];
+} tri_small_t;
+
+static INLINE int
+tri_is_small(const tri_setup_t* t) {
+    return (t->xmax - t->xmin + 1) * (t->ymax - t->ymin + 1) <= N_TRI_SMALL;
+}
+
+static int
+tri_small_setup(tri_small_t* s, const tri_setup_t* t) {
+    int x, y;
+    s->count = 0;
+    for (y = t->ymin; y <= t->ymax; y++) {
+        for (x = t->xmin; x <= t->xmax; x++) {
+            float a = t->e[0].w + (x - t->xmin) * t->e[0].dx + (y - t->ymin) * t->e[0].dy;
+            float b = t->e[1].w + (x - t->xmin) * t->e[1].dx + (y - t->ymin) * t->e[1].dy;
+            float g = t->e[2].w + (x - t->xmin) * t->e[2].dx + (y - t->ymin) * t->e[2].dy;
+            if (!edge_inside(a, &t->e[0]) || !edge_inside(b, &t->e[1]) || !edge_inside(g, &t->e[2])) continue;
+            s->x[s->count] = x;
+            s->y[s->count] = y;
+            s->a[s->count] = a;
+            s->b[s->count] = b;
+            s->g[s->count] = g;
+            s->count++;
+        }
+    }
+    return s->count;
+}
+
+static void
+tri_row_begin(float* inv_dx, const tri_setup_t* t) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        inv_dx[i] = t->e[i].dx != 0 ? 1.0f / t->e[i].dx : 0;
+    }
+}
+
+static INLINE int
+tri_row_range(const tri_setup_t* t, const float* inv_dx, float a, float b, float g, int* x0, int* x1) {
+    float w[3];
+    float l = (float)t->xmin, r = (float)t->xmax;
+    int i;
+    w[0] = a, w[1] = b, w[2] = g;
+    for (i = 0; i < 3; i++) {
+        float x = t->xmin - w[i] * inv_dx[i];
+        if (t->e[i].dx > 0) l = MAX(l, x);
+        else if (t->e[i].dx < 0) r = MIN(r, x);
+        else if (w[i] < 0) return 0;
+    }
+    if (l > r + 2.0f) return 0;
+    *x0 = MAX((int)l - 1, t->xmin);
+    *x1 = MIN((int)r + 1, t->xmax);
+    return *x0 <= *x1;
+}
+
+static void
+hiz_reset(void* depth) {
+    int i, count;
+    hiz.depth = depth;
+    hiz.width = ctx.width;
+    hiz.height = ctx.height;
+    hiz.w = (ctx.width + N_HIZ_SIZE - 1) / N_HIZ_SIZE;
+    hiz.h = (ctx.height + N_HIZ_SIZE - 1) / N_HIZ_SIZE;
+    count = hiz.w * hiz.h;
+
+    if (count > hiz.capacity) {
+        hiz.zmin = hiz.zmin ? x_realloc(hiz.zmin, sizeof(float) * count, 0)
+                            : x_alloc(sizeof(float) * count, 0);
+        hiz.capacity = count;
+    }
+    for (i = 0; i < count; i++) {
+        hiz.zmin[i] = -3.402823466e+38f;
+    }
+}
+
+static float*
+hiz_get(const target_t* tg) {
+    if (!tg->depth || tg->depth != hiz.depth) return 0;
+    if (hiz.width != ctx.width || hiz.height != ctx.height) return 0;
+    return hiz.zmin;
+}
+
+static int
+hiz_occluded(const float* hz, int xmin, int ymin, int xmax, int ymax, float zmax) {
+    int tx, ty;
+    for (ty = ymin / N_HIZ_SIZE; ty <= ymax / N_HIZ_SIZE; ty++) {
+        for (tx = xmin / N_HIZ_SIZE; tx <= xmax / N_HIZ_SIZE; tx++) {
+            if (zmax >= hz[ty * hiz.w + tx]) return 0;
+        }
+    }
+    return 1;
+}
+
+static void
+hiz_update(float* hz, const tri_setup_t* t) {
+    int tx, ty;
+    for (ty = t->ymin / N_HIZ_SIZE; ty <= t->ymax / N_HIZ_SIZE; ty++) {
+        int y0 = ty * N_HIZ_SIZE;
+        int y1 = MIN(y0 + N_HIZ_SIZE - 1, ctx.height - 1);
+        for (tx = t->xmin / N_HIZ_SIZE; tx <= t->xmax / N_HIZ_SIZE; tx++) {
+            int x0 = tx * N_HIZ_SIZE;
+            int x1 = MIN(x0 + N_HIZ_SIZE - 1, ctx.width - 1);
+            float* z = &hz[ty * hiz.w + tx];
+
+            if (t->zmin <= *z) continue;
+            if (tri_covers(t, x0, y0) && tri_covers(t, x1, y0) &&
+                tri_covers(t, x0, y1) && tri_covers(t, x1, y1)) {
+                *z = t->zmin;
+            }
+        }
+    }
+}
+
 static vec4_t
 m4_mul_v3_proj(mat4_t m, vec3_t v) {
     vec4_t res = m4_mul_v4(m, (vec4_t) {{ v.x, v.y,v.z, 1 }});
@@ -65,421 +713,1836 @@ m4_mul_v4_proj(mat4_t m, vec4_t v) {
         res.z /= res.w;
     }
 
-    return res;
+    return res;
+}
+
+void
+n_flag_toggle(drawing_flags_t flag) {
+    flags ^= flag;
+}
+
+void
+n_size_set(int width, int height) {
+    ctx.width = width;
+    ctx.height = height;
+    ctx.ox = width / 2;
+    ctx.oy = height / 2;
+    ctx.aspect = (float) height / width;
+}
+
+void
+n_clear_color_set(unsigned int color) {
+    ctx.clear_color = color;
+}
+
+void
+n_tex_filter_set(int filter) {
+    ctx.tex_filter = filter;
+}
+
+void
+n_depth_format_set(depth_format_t format) {
+    ctx.depth_format_next = format;
+}
+
+void
+n_tex_span_set(int pixels) {
+#ifdef SIMD_WIDTH
+    int span = SIMD_WIDTH;
+#else
+    int span = 2;
+#endif
+    if (pixels <= 0) {
+        ctx.tex_span = 0;
+        return;
+    }
+    while (span < pixels && span < 64) span <<= 1;
+    ctx.tex_span = span;
+}
+
+void
+n_clear(unsigned int* buffer, void* depth) {
+    int count = ctx.width * ctx.height;
+
+    ctx.fb_tiled = (flags & DRAW_FLAG_TILEDFB) &&
+                   ctx.width % N_FB_TILE == 0 && ctx.height % N_FB_TILE == 0;
+    ctx.depth_format = ctx.depth_format_next;
+
+    if (flags & DRAW_FLAG_LAZYCLEAR) {
+        lazy_begin(buffer, depth);
+    } else {
+        if (lazy.color == buffer) lazy.active = 0;
+        fill_color(buffer, ctx.clear_color, count, 1);
+        if (depth) fill_depth(depth, count, 1);
+    }
+    if (depth) {
+        hiz_reset(depth);
+    }
+}
+
+void
+n_clear_resolve(unsigned int* buffer, void* depth) {
+    lazy_touch(buffer, 0, 0, 0, ctx.width - 1, ctx.height - 1);
+    lazy_touch(0, depth, 0, 0, ctx.width - 1, ctx.height - 1);
+}
+
+static struct {
+    uint32_t* scratch;
+    int capacity;
+} layout;
+
+void
+n_layout_resolve(uint32_t* buffer) {
+    int count = ctx.width * ctx.height;
+    int tx, ty, r;
+
+    if (!ctx.fb_tiled) return;
+    lazy_touch(buffer, 0, 0, 0, ctx.width - 1, ctx.height - 1);
+
+    if (count > layout.capacity) {
+        layout.scratch = layout.scratch ? x_realloc(layout.scratch, sizeof(uint32_t) * count, 0)
+                                        : x_alloc(sizeof(uint32_t) * count, 0);
+        layout.capacity = count;
+    }
+    x_mem_copy(layout.scratch, buffer, sizeof(uint32_t) * count);
+
+    for (ty = 0; ty < ctx.height; ty += N_FB_TILE) {
+        for (tx = 0; tx < ctx.width; tx += N_FB_TILE) {
+            const uint32_t* src = layout.scratch + fb_index(tx, ty);
+            for (r = 0; r < N_FB_TILE; r++) {
+                uint32_t* dst = buffer + (ty + r) * ctx.width + tx;
+                int i = 0;
+#ifdef SIMD_WIDTH
+                for (; i < N_FB_TILE; i += SIMD_WIDTH) vi_store(dst + i, vi_load(src + i));
+#endif
+                for (; i < N_FB_TILE; i++) dst[i] = src[i];
+                src += N_FB_TILE;
+            }
+        }
+    }
+    ctx.fb_tiled = 0;
+}
+
+int n_point_draw(unsigned int* buffer, unsigned int x, unsigned int y, unsigned int color) {
+    if (x >= (unsigned)ctx.width || y >= (unsigned)ctx.height) return 0;
+    lazy_touch(buffer, 0, x, y, x, y);
+    buffer[fb_index(x, y)] = color;
+    return 1;
+}
+
+int n_depth_set(void* buffer, unsigned int x, unsigned int y, float depth) {
+    const int format = ctx.depth_format;
+    void* row = depth_ptr(buffer, fb_row(y, ctx.fb_tiled), format);
+    int ox = fb_col(x, ctx.fb_tiled);
+    float z = format == DEPTH_FORMAT_F32 ? depth : depth_quantize((depth + 0.5f) * depth_max(format), format);
+    lazy_touch(0, buffer, x, y, x, y);
+    if (z >= depth_load(row, ox, format)) {
+        depth_store(row, ox, z, format);
+        return 1;
+    }
+    return 0;
+}
+
+static INLINE int
+span_run(int x, int x1) {
+    return ctx.fb_tiled ? MIN(x1 - x + 1, N_FB_TILE - (x & (N_FB_TILE - 1))) : x1 - x + 1;
+}
+
+static void
+span_store(uint32_t* buffer, int x0, int x1, int y, uint32_t color) {
+    uint32_t* row = buffer + fb_row(y, ctx.fb_tiled);
+    int n;
+    for (; x0 <= x1; x0 += n) {
+        n = span_run(x0, x1);
+        fill_color(row + fb_col(x0, ctx.fb_tiled), color, n, 0);
+    }
+}
+
+static void
+span_fill(const target_t* tg, int x0, int x1, int y, uint32_t color) {
+    x0 = MAX(x0, tg->x0);
+    x1 = MIN(x1, tg->x1);
+    if (y < tg->y0 || y > tg->y1 || x0 > x1) return;
+    lazy_touch(tg->color, 0, x0, y, x1, y);
+    span_store(tg->color, x0, x1, y, color);
+}
+
+static void
+span_copy(const target_t* tg, int x, int y, const uint32_t* colors, int count) {
+    int x0 = MAX(x, tg->x0);
+    int x1 = MIN(x + count - 1, tg->x1);
+    int n;
+    if (y < tg->y0 || y > tg->y1 || x0 > x1) return;
+    lazy_touch(tg->color, 0, x0, y, x1, y);
+
+    uint32_t* row = tg->color + fb_row(y, ctx.fb_tiled);
+    for (; x0 <= x1; x0 += n) {
+        n = span_run(x0, x1);
+        x_mem_copy(row + fb_col(x0, ctx.fb_tiled), colors + (x0 - x), sizeof(uint32_t) * n);
+    }
+}
+
+static void
+vline_fill(const target_t* tg, int x, int y0, int y1, uint32_t color) {
+    int y;
+    y0 = MAX(y0, tg->y0);
+    y1 = MIN(y1, tg->y1);
+    if (x < tg->x0 || x > tg->x1 || y0 > y1) return;
+    lazy_touch(tg->color, 0, x, y0, x, y1);
+
+    uint32_t* column = tg->color + fb_col(x, ctx.fb_tiled);
+    for (y = y0; y <= y1; y++) {
+        column[fb_row(y, ctx.fb_tiled)] = color;
+    }
+}
+
+static void
+rect_fill(const target_t* tg, int x0, int y0, int x1, int y1, uint32_t color) {
+    int y;
+    x0 = MAX(x0, tg->x0);
+    y0 = MAX(y0, tg->y0);
+    x1 = MIN(x1, tg->x1);
+    y1 = MIN(y1, tg->y1);
+    if (x0 > x1 || y0 > y1) return;
+    lazy_touch(tg->color, 0, x0, y0, x1, y1);
+    for (y = y0; y <= y1; y++) {
+        span_store(tg->color, x0, x1, y, color);
+    }
+}
+
+void
+n_span_fill(uint32_t* buffer, int x, int y, const uint32_t* colors, int count) {
+    target_t tg = target_full(buffer, 0);
+    span_copy(&tg, x, y, colors, count);
+}
+
+void
+n_hline(uint32_t* buffer, int x0, int x1, int y, uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    span_fill(&tg, MIN(x0, x1), MAX(x0, x1), y, color);
+}
+
+void
+n_vline(uint32_t* buffer, int x, int y0, int y1, uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    vline_fill(&tg, x, MIN(y0, y1), MAX(y0, y1), color);
+}
+
+void
+n_rect_fill(uint32_t* buffer, int x0, int y0, int x1, int y1, uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    rect_fill(&tg, MIN(x0, x1), MIN(y0, y1), MAX(x0, x1), MAX(y0, y1), color);
+}
+
+typedef struct {
+    int x, y;
+    int sx, sy;
+    int64_t dx, dy, e;
+    int xe, ye;
+    int64_t first, count, length;
+} line_t;
+
+static int64_t
+div_floor(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static INLINE int64_t
+line_minor(const line_t* l, int64_t k) {
+    int64_t n = MAX(l->dx, l->dy), d = MIN(l->dx, l->dy);
+    return n ? (2 * d * k + n) / (2 * n) : 0;
+}
+
+static int
+line_setup(line_t* l, const target_t* tg, int x1, int y1, int x2, int y2) {
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+    l->sx = dx < 0 ? -1 : 1;
+    l->sy = dy < 0 ? -1 : 1;
+    l->dx = dx * l->sx;
+    l->dy = dy * l->sy;
+
+    int64_t xlo = l->sx > 0 ? (int64_t)tg->x0 - x1 : (int64_t)x1 - tg->x1;
+    int64_t xhi = l->sx > 0 ? (int64_t)tg->x1 - x1 : (int64_t)x1 - tg->x0;
+    int64_t ylo = l->sy > 0 ? (int64_t)tg->y0 - y1 : (int64_t)y1 - tg->y1;
+    int64_t yhi = l->sy > 0 ? (int64_t)tg->y1 - y1 : (int64_t)y1 - tg->y0;
+    int xmajor = l->dx >= l->dy;
+    int64_t n = xmajor ? l->dx : l->dy;
+    int64_t d = xmajor ? l->dy : l->dx;
+    int64_t lo = xmajor ? ylo : xlo;
+    int64_t hi = xmajor ? yhi : xhi;
+    int64_t k0 = MAX(0, (xmajor ? xlo : ylo));
+    int64_t k1 = MIN(n, (xmajor ? xhi : yhi));
+
+    if (d == 0) {
+        if (lo > 0 || hi < 0) return 0;
+    } else {
+        k0 = MAX(k0, div_floor(2 * n * lo - n + 2 * d - 1, 2 * d));
+        k1 = MIN(k1, div_floor(2 * n * hi + n - 1, 2 * d));
+    }
+    if (k0 > k1) return 0;
+
+    int64_t m0 = line_minor(l, k0), m1 = line_minor(l, k1);
+    int64_t nx = xmajor ? k0 : m0, ny = xmajor ? m0 : k0;
+    l->x = (int)(x1 + l->sx * nx);
+    l->y = (int)(y1 + l->sy * ny);
+    l->e = l->dx - l->dy - nx * l->dy + ny * l->dx;
+    l->xe = (int)(x1 + l->sx * (xmajor ? k1 : m1));
+    l->ye = (int)(y1 + l->sy * (xmajor ? m1 : k1));
+    l->first = k0;
+    l->count = k1 - k0 + 1;
+    l->length = n;
+    return 1;
+}
+
+static INLINE void
+line_step(line_t* l) {
+    int64_t e2 = 2 * l->e;
+    if (e2 >= -l->dy) {
+        l->e -= l->dy;
+        l->x += l->sx;
+    }
+    if (e2 <= l->dx) {
+        l->e += l->dx;
+        l->y += l->sy;
+    }
+}
+
+static void
+line_touch(const target_t* tg, const line_t* l) {
+    lazy_touch(tg->color, 0, MIN(l->x, l->xe), MIN(l->y, l->ye), MAX(l->x, l->xe), MAX(l->y, l->ye));
+}
+
+static void
+line_draw(const target_t* tg, int x1, int y1, int x2, int y2, uint32_t color) {
+    line_t l;
+    int64_t i;
+
+    if (y1 == y2) {
+        span_fill(tg, MIN(x1, x2), MAX(x1, x2), y1, color);
+        return;
+    }
+    if (x1 == x2) {
+        vline_fill(tg, x1, MIN(y1, y2), MAX(y1, y2), color);
+        return;
+    }
+    if (!line_setup(&l, tg, x1, y1, x2, y2)) return;
+
+    line_touch(tg, &l);
+    for (i = 0; i < l.count; i++) {
+        tg->color[fb_index(l.x, l.y)] = color;
+        line_step(&l);
+    }
+}
+
+void
+n_line2d_draw(unsigned int* buffer, int x1, int y1, int x2, int y2, unsigned int color)
+{
+    target_t tg = target_full(buffer, 0);
+    line_draw(&tg, x1, y1, x2, y2, color);
+}
+
+void
+n_line2d_draw_gradient(unsigned int* buffer, int x1, int y1, int x2, int y2, unsigned int color1, unsigned int color2)
+{
+    target_t tg = target_full(buffer, 0);
+    line_t l;
+    int32_t c[4], step[4];
+    int64_t i;
+    int ch;
+
+    if (!line_setup(&l, &tg, x1, y1, x2, y2)) return;
+
+    for (ch = 0; ch < 4; ch++) {
+        int32_t a = (color1 >> (ch * 8)) & 0xff;
+        int32_t b = (color2 >> (ch * 8)) & 0xff;
+        step[ch] = l.length ? (int32_t)(((int64_t)(b - a) << 16) / l.length) : 0;
+        c[ch] = (a << 16) + (int32_t)(step[ch] * l.first);
+    }
+
+    line_touch(&tg, &l);
+    for (i = 0; i < l.count; i++) {
+        uint32_t color = 0;
+        for (ch = 0; ch < 4; ch++) {
+            color |= (uint32_t)(c[ch] >> 16) << (ch * 8);
+            c[ch] += step[ch];
+        }
+        tg.color[fb_index(l.x, l.y)] = color;
+        line_step(&l);
+    }
+}
+
+void n_texture_draw(uint32_t* buffer, int w, int h) {
+    target_t tg = target_full(buffer, 0);
+    uint32_t texels[64];
+    int cw = MIN(w, ctx.width);
+    int ch = MIN(h, ctx.height);
+    int x, y, i;
+    for (y = 0; y < ch; y++) {
+        for (x = 0; x < cw; x += 64) {
+            int count = MIN(64, cw - x);
+            for (i = 0; i < count; i++) {
+                texels[i] = texture_get_color((float)(x + i) / w, (float)y / h);
+            }
+            span_copy(&tg, x, y, texels, count);
+        }
+    }
+}
+
+void
+n_grid_line_draw(uint32_t* buffer, int w, int h, int size) {
+    target_t tg = target_full(buffer, 0);
+    int x, y;
+    for (y = 0; y < h; y += size) {
+        span_fill(&tg, 0, w - 1, y, 0xff333333);
+    }
+    for (x = 0; x < w; x += size) {
+        vline_fill(&tg, x, 0, h - 1, 0xff333333);
+    }
+}
+
+void
+n_grid_dot_draw(uint32_t* buffer,
+                int w, int h,
+                int size, float time) {
+    float ratio[256];
+    float step = size * 0.02f;
+    int x, y, i, count;
+    for (y = size / 2; y < h; y+=size) {
+        for (x = size / 2; x < w; x += count * size) {
+            count = MIN((w - x + size - 1) / size, 256);
+            mm_noise2d_batch(ratio, x * 0.02f + time, y * 0.02f + time, step, count, 1, 0);
+            for (i = 0; i < count; i++) {
+                uint32_t c = (uint8_t)(ratio[i] * 255.0f);
+                n_point_draw(buffer, x + i * size, y, 0xff000000 | c << 16 | c << 8 | c);
+            }
+        }
+    }
+}
+
+void
+n_rect_fill_draw(uint32_t* buffer, int sx, int sy, int width, int height, uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    rect_fill(&tg, sx, sy, sx + width - 1, sy + height - 1, color);
+}
+
+static void
+tri_dots_draw(const target_t* tg,
+              int x1, int y1,
+              int x2, int y2,
+              int x3, int y3,
+              uint32_t color) {
+    rect_fill(tg, x1, y1, x1 + 3, y1 + 3, color);
+    rect_fill(tg, x2, y2, x2 + 3, y2 + 3, color);
+    rect_fill(tg, x3, y3, x3 + 3, y3 + 3, color);
+}
+
+void
+n_triangle_dots_draw(uint32_t* buffer,
+                     float x1, float y1,
+                     float x2, float y2,
+                     float x3, float y3,
+                     uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    tri_dots_draw(&tg, x1, y1, x2, y2, x3, y3, color);
+}
+
+static void
+tri_wire_draw(const target_t* tg,
+              int x1, int y1,
+              int x2, int y2,
+              int x3, int y3,
+              uint32_t color) {
+    line_draw(tg, x1, y1, x2, y2, color);
+    line_draw(tg, x2, y2, x3, y3, color);
+    line_draw(tg, x3, y3, x1, y1, color);
+}
+
+void
+n_triangle_wire_draw(uint32_t* buffer,
+                     float x1, float y1,
+                     float x2, float y2,
+                     float x3, float y3,
+                     uint32_t color) {
+    target_t tg = target_full(buffer, 0);
+    tri_wire_draw(&tg, x1, y1, x2, y2, x3, y3, color);
+}
+
+uint32_t
+n_color_percent(uint32_t color,
+                float precent) {
+    color_t c = { color };
+    c.r *= precent;
+    c.g *= precent;
+    c.b *= precent;
+    return c.hex;
+}
+
+uint32_t
+n_color_mix3(uint32_t c1, uint32_t c2, uint32_t c3) {
+    const float p = 1.0f / 3.0f;
+    color_t c11 = { c1 };
+    color_t c22 = { c2 };
+    color_t c33 = { c3 };
+    c11.r *= p; c11.g *= p; c11.b *= p; c11.a = 0;
+    c22.r *= p; c22.g *= p; c22.b *= p; c22.a = 0;
+    c33.r *= p; c33.g *= p; c33.b *= p; c33.a = 0;
+    return 0xff000000 | ( c11.hex + c22.hex + c33.hex );
+}
+
+N_KERNEL void
+tri_tex_kernel(const target_t* tg, const int fullrect, const int spanned, const void* texture,
+               int x1, int y1, float z1, float w1, float u1, float v1,
+               int x2, int y2, float z2, float w2, float u2, float v2,
+               int x3, int y3, float z3, float w3, float u3, float v3,
+               const int tiled, const int format) {
+    tri_setup_t t;
+    int x, y;
+
+    if (!tri_setup(&t, tg, x1, y1, z1, x2, y2, z2, x3, y3, z3)) return;
+
+    tri_small_t sm;
+    int small = !fullrect && tri_is_small(&t);
+    if (small && !tri_small_setup(&sm, &t)) return;
+
+    float* hz = fullrect || small ? 0 : hiz_get(tg);
+    if (hz && hiz_occluded(hz, t.xmin, t.ymin, t.xmax, t.ymax, t.zmax)) return;
+
+    tex_persp_t tp;
+    tex_persp_setup(&tp, t.inv_area, w1, u1, v1, w2, u2, v2, w3, u3, v3);
+    uint32_t level = tex_level(texture, t.inv_area, u1, v1, u2, v2, u3, v3);
+
+    const int filter = ctx.tex_filter;
+
+    const int span = ctx.tex_span;
+    plane_eq_t pr, pu, pv;
+    tex_span_t ts;
+    if (spanned) {
+        plane_eq_setup(&pr, &t, x1, y1, 1.0f / w1, 1.0f / w2, 1.0f / w3);
+        plane_eq_setup(&pu, &t, x1, y1, u1 / w1, u2 / w2, u3 / w3);
+        plane_eq_setup(&pv, &t, x1, y1, v1 / w1, v2 / w2, v3 / w3);
+        tex_span_begin(&ts, &t, span);
+    }
+
+    if (small) {
+        int i, ry = t.ymin, sy = -1;
+        float ra = t.e[0].w, rb = t.e[1].w, rg = t.e[2].w;
+        float qr = 0, qu = 0, qv = 0;
+        for (i = 0; i < sm.count; i++) {
+            uint32_t* crow = tg->color + fb_row(sm.y[i], tiled);
+            void* drow = depth_ptr(tg->depth, fb_row(sm.y[i], tiled), format);
+            int ox = fb_col(sm.x[i], tiled);
+            float z = depth_quantize(t.zbias + sm.a[i] * t.z1 + sm.b[i] * t.z2 + sm.g[i] * t.z3, format);
+            if (z < depth_load(drow, ox, format)) continue;
+
+            float u, v;
+            if (spanned) {
+                int sx = sm.x[i] & ~(span - 1);
+                if (sm.y[i] != sy) {
+                    for (; ry < sm.y[i]; ry++) {
+                        ra += t.e[0].dy;
+                        rb += t.e[1].dy;
+                        rg += t.e[2].dy;
+                    }
+                    sy = sm.y[i];
+                    qr = plane_eq_row(&pr, sy);
+                    qu = plane_eq_row(&pu, sy);
+                    qv = plane_eq_row(&pv, sy);
+                    tex_span_row(&ts, &t, ra, rb, rg);
+                }
+                if (sx != ts.x) tex_span_setup(&ts, sx, span, &pr, &pu, &pv, qr, qu, qv);
+                u = ts.u + (sm.x[i] - sx) * ts.du;
+                v = ts.v + (sm.x[i] - sx) * ts.dv;
+            } else {
+                tex_persp(&tp, sm.a[i], sm.b[i], sm.g[i], &u, &v);
+            }
+            depth_store(drow, ox, z, format);
+            texture_sample_from_asset((const struct asset_texture_t*)texture, &u, &v, &crow[ox], 1, level, filter);
+        }
+        return;
+    }
+
+    float inv_dx[3];
+    int large = !fullrect && t.xmax - t.xmin >= N_TRI_LARGE;
+    if (large) tri_row_begin(inv_dx, &t);
+
+#ifdef SIMD_WIDTH
+    edge_v_t ev[3];
+    vf_t all = vf_eq(vf_set1(0), vf_set1(0));
+    vf_t rect = fullrect ? all : vf_set1(0);
+    int xa = t.xmin & ~(SIMD_WIDTH - 1);
+    int xb = tg->x1 - SIMD_WIDTH + 1;
+    float ea = SIMD_WIDTH * t.e[0].dx, eb = SIMD_WIDTH * t.e[1].dx, eg = SIMD_WIDTH * t.e[2].dx;
+    edge_v_setup(&ev[0], &t.e[0]);
+    edge_v_setup(&ev[1], &t.e[1]);
+    edge_v_setup(&ev[2], &t.e[2]);
+#endif
+
+    float ra = t.e[0].w, rb = t.e[1].w, rg = t.e[2].w;
+
+    for (y = t.ymin; y <= t.ymax; y++, ra += t.e[0].dy, rb += t.e[1].dy, rg += t.e[2].dy) {
+        uint32_t* crow = tg->color + fb_row(y, tiled);
+        void* drow = depth_ptr(tg->depth, fb_row(y, tiled), format);
+        float a, b, g;
+        float qr = 0, qu = 0, qv = 0;
+        int rx0 = t.xmin, rx1 = t.xmax;
+
+        if (large && !tri_row_range(&t, inv_dx, ra, rb, rg, &rx0, &rx1)) continue;
+        if (spanned) {
+            qr = plane_eq_row(&pr, y);
+            qu = plane_eq_row(&pu, y);
+            qv = plane_eq_row(&pv, y);
+            tex_span_row(&ts, &t, ra, rb, rg);
+        }
+
+        x = rx0;
+#ifdef SIMD_WIDTH
+        const float* hrow = hz ? hz + (y / N_HIZ_SIZE) * hiz.w : 0;
+        int xs = large ? rx0 & ~(SIMD_WIDTH - 1) : xa;
+        a = ra + (xs - t.xmin) * t.e[0].dx;
+        b = rb + (xs - t.xmin) * t.e[1].dx;
+        g = rg + (xs - t.xmin) * t.e[2].dx;
+
+        for (x = xs; x <= rx1 && x <= xb; x += SIMD_WIDTH, a += ea, b += eb, g += eg) {
+            if (hrow && t.zmax < hrow[x / N_HIZ_SIZE]) continue;
+
+            vf_t va = vf_add(vf_set1(a), ev[0].step);
+            vf_t vb = vf_add(vf_set1(b), ev[1].step);
+            vf_t vg = vf_add(vf_set1(g), ev[2].step);
+            vf_t px = vf_add(vf_set1(x), vf_ramp());
+            vf_t range = vf_and(vf_ge(px, vf_set1(t.xmin)), vf_ge(vf_set1(t.xmax), px));
+
+            vf_t in = vf_and(vf_and(edge_inside_v(va, &ev[0]), edge_inside_v(vb, &ev[1])), edge_inside_v(vg, &ev[2]));
+            in = vf_and(in, range);
+            vf_t write = vf_and(vf_or(in, rect), range);
+            if (!vf_mask(write)) continue;
+
+            vf_t z = vf_add(vf_add(vf_add(vf_set1(t.zbias), vf_mul(va, vf_set1(t.z1))), vf_mul(vb, vf_set1(t.z2))), vf_mul(vg, vf_set1(t.z3)));
+            int ox = fb_col(x, tiled);
+            vf_t d = depth_load_v(drow, ox, format);
+            z = depth_quantize_v(z, format);
+            write = vf_and(write, vf_ge(z, d));
+
+            int mask = vf_mask(write);
+            if (!mask) continue;
+
+            int inside = vf_mask(in) & mask;
+            uint32_t texels[SIMD_WIDTH];
+            float us[SIMD_WIDTH], vs[SIMD_WIDTH];
+            int i;
+
+            if (inside && spanned) {
+                int sx = x & ~(span - 1);
+                if (sx != ts.x) tex_span_setup(&ts, sx, span, &pr, &pu, &pv, qr, qu, qv);
+                vf_t dx = vf_sub(px, vf_set1(sx));
+                vf_store(us, vf_and(vf_add(vf_set1(ts.u), vf_mul(dx, vf_set1(ts.du))), in));
+                vf_store(vs, vf_and(vf_add(vf_set1(ts.v), vf_mul(dx, vf_set1(ts.dv))), in));
+            } else if (inside) {
+                tex_persp_v(&tp, va, vb, vg, in, us, vs);
+            }
+
+            if (inside) {
+                texture_sample_from_asset((const struct asset_texture_t*)texture, us, vs, texels, SIMD_WIDTH, level, filter);
+            }
+            for (i = 0; i < SIMD_WIDTH; i++) {
+                if (!(inside >> i & 1)) texels[i] = 0xff00ff00;
+            }
+
+            depth_store_v(drow, ox, vf_select(write, z, d), format);
+            vi_store(crow + ox, vi_select(write, vi_load(texels), vi_load(crow + ox)));
+        }
+        x = MAX(x, t.xmin);
+#endif
+        a = ra + (x - t.xmin) * t.e[0].dx;
+        b = rb + (x - t.xmin) * t.e[1].dx;
+        g = rg + (x - t.xmin) * t.e[2].dx;
+
+        for (; x <= rx1; x++) {
+            int ox = fb_col(x, tiled);
+            if (edge_inside(a, &t.e[0]) && edge_inside(b, &t.e[1]) && edge_inside(g, &t.e[2])) {
+                float z = depth_quantize(t.zbias + a * t.z1 + b * t.z2 + g * t.z3, format);
+
+                if (z >= depth_load(drow, ox, format)) {
+                    float u, v;
+                    if (spanned) {
+                        int sx = x & ~(span - 1);
+                        if (sx != ts.x) tex_span_setup(&ts, sx, span, &pr, &pu, &pv, qr, qu, qv);
+                        u = ts.u + (x - sx) * ts.du;
+                        v = ts.v + (x - sx) * ts.dv;
+                    } else {
+                        tex_persp(&tp, a, b, g, &u, &v);
+                    }
+                    depth_store(drow, ox, z, format);
+                    texture_sample_from_asset((const struct asset_texture_t*)texture, &u, &v, &crow[ox], 1, level, filter);
+                }
+            } else if (fullrect) {
+                float z = depth_quantize(t.zbias + a * t.z1 + b * t.z2 + g * t.z3, format);
+
+                if (z >= depth_load(drow, ox, format)) {
+                    depth_store(drow, ox, z, format);
+                    crow[ox] = 0xff00ff00;
+                }
+            }
+            a += t.e[0].dx;
+            b += t.e[1].dx;
+            g += t.e[2].dx;
+        }
+    }
+
+    if (hz) hiz_update(hz, &t);
+}
+
+static void
+tri_tex_draw(const target_t* tg, const void* texture,
+             int x1, int y1, float z1, float w1, float u1, float v1,
+             int x2, int y2, float z2, float w2, float u2, float v2,
+             int x3, int y3, float z3, float w3, float u3, float v3) {
+    if (ctx.tex_span) {
+        N_TARGET_DISPATCH(tri_tex_kernel, tg, 0, 1, texture,
+                          x1, y1, z1, w1, u1, v1,
+                          x2, y2, z2, w2, u2, v2,
+                          x3, y3, z3, w3, u3, v3)
+    } else {
+        N_TARGET_DISPATCH(tri_tex_kernel, tg, 0, 0, texture,
+                          x1, y1, z1, w1, u1, v1,
+                          x2, y2, z2, w2, u2, v2,
+                          x3, y3, z3, w3, u3, v3)
+    }
+}
+
+static void
+tri_tex_rect_draw(const target_t* tg, const void* texture,
+                  int x1, int y1, float z1, float w1, float u1, float v1,
+                  int x2, int y2, float z2, float w2, float u2, float v2,
+                  int x3, int y3, float z3, float w3, float u3, float v3) {
+    if (ctx.tex_span) {
+        N_TARGET_DISPATCH(tri_tex_kernel, tg, 1, 1, texture,
+                          x1, y1, z1, w1, u1, v1,
+                          x2, y2, z2, w2, u2, v2,
+                          x3, y3, z3, w3, u3, v3)
+    } else {
+        N_TARGET_DISPATCH(tri_tex_kernel, tg, 1, 0, texture,
+                          x1, y1, z1, w1, u1, v1,
+                          x2, y2, z2, w2, u2, v2,
+                          x3, y3, z3, w3, u3, v3)
+    }
+}
+
+void
+n_triangle_tex_draw(uint32_t* color, void* depth, const void* texture,
+                    int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1,
+                    int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2,
+                    int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3) {
+    target_t tg = target_full(color, depth);
+    if (flags & DRAW_FLAG_FULLRECT) {
+        tri_tex_rect_draw(&tg, texture,
+                          x1, y1, z1, w1, u1, v1,
+                          x2, y2, z2, w2, u2, v2,
+                          x3, y3, z3, w3, u3, v3);
+    } else {
+        tri_tex_draw(&tg, texture,
+                     x1, y1, z1, w1, u1, v1,
+                     x2, y2, z2, w2, u2, v2,
+                     x3, y3, z3, w3, u3, v3);
+    }
+}
+
+N_KERNEL void
+tri_fill_kernel(const target_t* tg, const int fullrect, const int wired,
+                int x1, int y1, float z1,
+                int x2, int y2, float z2,
+                int x3, int y3, float z3,
+                uint32_t final, const uint32_t* wire, const int tiled, const int format) {
+    tri_setup_t t;
+    int x, y;
+
+    if (!tri_setup(&t, tg, x1, y1, z1, x2, y2, z2, x3, y3, z3)) return;
+
+    tri_small_t sm;
+    int small = !fullrect && tri_is_small(&t);
+    if (small && !tri_small_setup(&sm, &t)) return;
+
+    float* hz = fullrect || small ? 0 : hiz_get(tg);
+    if (hz && hiz_occluded(hz, t.xmin, t.ymin, t.xmax, t.ymax, t.zmax)) return;
+
+    edge_wire_t ew[3];
+    if (wired) {
+        edge_wire_setup(&ew[0], &t.e[0]);
+        edge_wire_setup(&ew[1], &t.e[1]);
+        edge_wire_setup(&ew[2], &t.e[2]);
+    }
+
+    if (small) {
+        int i;
+        for (i = 0; i < sm.count; i++) {
+            uint32_t* crow = tg->color + fb_row(sm.y[i], tiled);
+            void* drow = depth_ptr(tg->depth, fb_row(sm.y[i], tiled), format);
+            int ox = fb_col(sm.x[i], tiled);
+            float z = depth_quantize(t.zbias + sm.a[i] * t.z1 + sm.b[i] * t.z2 + sm.g[i] * t.z3, format);
+            if (z < depth_load(drow, ox, format)) continue;
+
+            depth_store(drow, ox, z, format);
+            crow[ox] = wired ? edge_wire_pick(ew, wire, sm.a[i], sm.b[i], sm.g[i], final) : final;
+        }
+        return;
+    }
+
+    float inv_dx[3];
+    int large = !fullrect && t.xmax - t.xmin >= N_TRI_LARGE;
+    if (large) tri_row_begin(inv_dx, &t);
+
+#ifdef SIMD_WIDTH
+    edge_v_t ev[3];
+    vf_t all = vf_eq(vf_set1(0), vf_set1(0));
+    vf_t rect = fullrect ? all : vf_set1(0);
+    vi_t vfinal = vi_set1(final);
+    vi_t vgreen = vi_set1(0xff00ff00);
+    int xa = t.xmin & ~(SIMD_WIDTH - 1);
+    int xb = tg->x1 - SIMD_WIDTH + 1;
+    float ea = SIMD_WIDTH * t.e[0].dx, eb = SIMD_WIDTH * t.e[1].dx, eg = SIMD_WIDTH * t.e[2].dx;
+    edge_v_setup(&ev[0], &t.e[0]);
+    edge_v_setup(&ev[1], &t.e[1]);
+    edge_v_setup(&ev[2], &t.e[2]);
+#endif
+
+    float ra = t.e[0].w, rb = t.e[1].w, rg = t.e[2].w;
+
+    for (y = t.ymin; y <= t.ymax; y++, ra += t.e[0].dy, rb += t.e[1].dy, rg += t.e[2].dy) {
+        uint32_t* crow = tg->color + fb_row(y, tiled);
+        void* drow = depth_ptr(tg->depth, fb_row(y, tiled), format);
+        float a, b, g;
+        int rx0 = t.xmin, rx1 = t.xmax;
+
+        if (large && !tri_row_range(&t, inv_dx, ra, rb, rg, &rx0, &rx1)) continue;
+
+        x = rx0;
+#ifdef SIMD_WIDTH
+        const float* hrow = hz ? hz + (y / N_HIZ_SIZE) * hiz.w : 0;
+        int xs = large ? rx0 & ~(SIMD_WIDTH - 1) : xa;
+        a = ra + (xs - t.xmin) * t.e[0].dx;
+        b = rb + (xs - t.xmin) * t.e[1].dx;
+        g = rg + (xs - t.xmin) * t.e[2].dx;
+
+        for (x = xs; x <= rx1 && x <= xb; x += SIMD_WIDTH, a += ea, b += eb, g += eg) {
+            if (hrow && t.zmax < hrow[x / N_HIZ_SIZE]) continue;
+
+            vf_t va = vf_add(vf_set1(a), ev[0].step);
+            vf_t vb = vf_add(vf_set1(b), ev[1].step);
+            vf_t vg = vf_add(vf_set1(g), ev[2].step);
+            vf_t px = vf_add(vf_set1(x), vf_ramp());
+            vf_t range = vf_and(vf_ge(px, vf_set1(t.xmin)), vf_ge(vf_set1(t.xmax), px));
+
+            vf_t in = vf_and(vf_and(edge_inside_v(va, &ev[0]), edge_inside_v(vb, &ev[1])), edge_inside_v(vg, &ev[2]));
+            in = vf_and(in, range);
+            vf_t write = vf_and(vf_or(in, rect), range);
+            if (!vf_mask(write)) continue;
+
+            vf_t z = vf_add(vf_add(vf_add(vf_set1(t.zbias), vf_mul(va, vf_set1(t.z1))), vf_mul(vb, vf_set1(t.z2))), vf_mul(vg, vf_set1(t.z3)));
+            int ox = fb_col(x, tiled);
+            vf_t d = depth_load_v(drow, ox, format);
+            z = depth_quantize_v(z, format);
+            write = vf_and(write, vf_ge(z, d));
+            if (!vf_mask(write)) continue;
+
+            vi_t fill = wired ? edge_wire_pick_v(ew, wire, va, vb, vg, vfinal) : vfinal;
+
+            depth_store_v(drow, ox, vf_select(write, z, d), format);
+            vi_store(crow + ox, vi_select(write, vi_select(in, fill, vgreen), vi_load(crow + ox)));
+        }
+        x = MAX(x, t.xmin);
+#endif
+        a = ra + (x - t.xmin) * t.e[0].dx;
+        b = rb + (x - t.xmin) * t.e[1].dx;
+        g = rg + (x - t.xmin) * t.e[2].dx;
+
+        for (; x <= rx1; x++) {
+            int ox = fb_col(x, tiled);
+            if (edge_inside(a, &t.e[0]) && edge_inside(b, &t.e[1]) && edge_inside(g, &t.e[2])) {
+                float z = depth_quantize(t.zbias + a * t.z1 + b * t.z2 + g * t.z3, format);
+
+                if (z >= depth_load(drow, ox, format)) {
+                    depth_store(drow, ox, z, format);
+                    crow[ox] = wired ? edge_wire_pick(ew, wire, a, b, g, final) : final;
+                }
+            } else if (fullrect) {
+                float z = depth_quantize(t.zbias + a * t.z1 + b * t.z2 + g * t.z3, format);
+
+                if (z >= depth_load(drow, ox, format)) {
+                    depth_store(drow, ox, z, format);
+                    crow[ox] = 0xff00ff00;
+                }
+            }
+            a += t.e[0].dx;
+            b += t.e[1].dx;
+            g += t.e[2].dx;
+        }
+    }
+
+    if (hz) hiz_update(hz, &t);
+}
+
+static void
+tri_fill_draw(const target_t* tg,
+              int x1, int y1, float z1,
+              int x2, int y2, float z2,
+              int x3, int y3, float z3,
+              uint32_t final) {
+    N_TARGET_DISPATCH(tri_fill_kernel, tg, 0, 0, x1, y1, z1, x2, y2, z2, x3, y3, z3, final, NULL)
+}
+
+static void
+tri_fill_rect_draw(const target_t* tg,
+                   int x1, int y1, float z1,
+                   int x2, int y2, float z2,
+                   int x3, int y3, float z3,
+                   uint32_t final) {
+    N_TARGET_DISPATCH(tri_fill_kernel, tg, 1, 0, x1, y1, z1, x2, y2, z2, x3, y3, z3, final, NULL)
+}
+
+static void
+tri_fill_wire_draw(const target_t* tg,
+                   int x1, int y1, float z1,
+                   int x2, int y2, float z2,
+                   int x3, int y3, float z3,
+                   uint32_t final, const uint32_t* wire) {
+    N_TARGET_DISPATCH(tri_fill_kernel, tg, 0, 1, x1, y1, z1, x2, y2, z2, x3, y3, z3, final, wire)
+}
+
+static void
+tri_fill_wire_rect_draw(const target_t* tg,
+                        int x1, int y1, float z1,
+                        int x2, int y2, float z2,
+                        int x3, int y3, float z3,
+                        uint32_t final, const uint32_t* wire) {
+    N_TARGET_DISPATCH(tri_fill_kernel, tg, 1, 1, x1, y1, z1, x2, y2, z2, x3, y3, z3, final, wire)
+}
+
+void
+n_triangle_fill_draw(uint32_t* color, void* depth,
+                     int x1, int y1, float z1, uint32_t c1,
+                     int x2, int y2, float z2, uint32_t c2,
+                     int x3, int y3, float z3, uint32_t c3) {
+    target_t tg = target_full(color, depth);
+    uint32_t final = n_color_mix3(c1, c2, c3);
+    if (flags & DRAW_FLAG_FULLRECT) {
+        tri_fill_rect_draw(&tg, x1, y1, z1, x2, y2, z2, x3, y3, z3, final);
+    } else {
+        tri_fill_draw(&tg, x1, y1, z1, x2, y2, z2, x3, y3, z3, final);
+    }
+}
+
+void int_swap(int* a, int* b) {
+    int tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+void float_swap(float* a, float* b) {
+    float tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+typedef struct {
+    int32_t w;
+    int32_t dx;
+    int32_t dy;
+    int32_t thr;
+} edge_fixed_t;
+
+typedef struct {
+    edge_fixed_t e[3];
+    float inv_area;
+    float zbias, z1, z2, z3;
+    float zmin, zmax;
+    int xmin, ymin, xmax, ymax;
+} tri_fixed_t;
+
+static int32_t
+fixed_from_float(float v) {
+    return (int32_t)mm_floor(v * N_SUBPIXEL_ONE + 0.5f);
+}
+
+static int
+fixed_to_int(int32_t v) {
+    return (v + N_SUBPIXEL_ONE / 2) >> N_SUBPIXEL_BITS;
+}
+
+static int64_t
+edge_fixed_eval(int32_t ax, int32_t ay, int32_t bx, int32_t by, int64_t px, int64_t py) {
+    return (px - ax) * (int64_t)(by - ay) - (py - ay) * (int64_t)(bx - ax);
+}
+
+static int
+edge_fixed_setup(edge_fixed_t* e, const tri_fixed_t* t,
+                 int32_t ax, int32_t ay, int32_t bx, int32_t by, int tl) {
+    const int64_t half = N_SUBPIXEL_ONE / 2;
+    int64_t x0 = (int64_t)(t->xmin - 8) * N_SUBPIXEL_ONE + half;
+    int64_t x1 = (int64_t)(t->xmax + 8) * N_SUBPIXEL_ONE + half;
+    int64_t y0 = (int64_t)t->ymin * N_SUBPIXEL_ONE + half;
+    int64_t y1 = (int64_t)(t->ymax + 1) * N_SUBPIXEL_ONE + half;
+    int64_t c[4];
+    int i;
+
+    c[0] = edge_fixed_eval(ax, ay, bx, by, x0, y0);
+    c[1] = edge_fixed_eval(ax, ay, bx, by, x1, y0);
+    c[2] = edge_fixed_eval(ax, ay, bx, by, x0, y1);
+    c[3] = edge_fixed_eval(ax, ay, bx, by, x1, y1);
+    for (i = 0; i < 4; i++) {
+        if (c[i] > INT32_MAX || c[i] < INT32_MIN) return 0;
+    }
+
+    e->w = (int32_t)edge_fixed_eval(ax, ay, bx, by, x0 + 8 * N_SUBPIXEL_ONE, y0);
+    e->dx = (by - ay) * N_SUBPIXEL_ONE;
+    e->dy = (ax - bx) * N_SUBPIXEL_ONE;
+    e->thr = tl ? -1 : 0;
+    return 1;
+}
+
+static INLINE int
+edge_fixed_inside(int32_t w, const edge_fixed_t* e) {
+    return w > e->thr;
+}
+
+static INLINE int32_t
+edge_fixed_wire_limit(const edge_fixed_t* e) {
+    int32_t dx = e->dx < 0 ? -e->dx : e->dx;
+    int32_t dy = e->dy < 0 ? -e->dy : e->dy;
+    return MAX(dx, dy) / 2 - e->thr;
+}
+
+static INLINE uint32_t
+edge_fixed_wire_pick(const int32_t* limit, const uint32_t* wire, int32_t a, int32_t b, int32_t g, uint32_t fill) {
+    if (a < limit[0]) return wire[0];
+    if (b < limit[1]) return wire[1];
+    if (g < limit[2]) return wire[2];
+    return fill;
+}
+
+static int
+tri_fixed_setup(tri_fixed_t* t, const target_t* tg,
+                int32_t x1, int32_t y1, float z1,
+                int32_t x2, int32_t y2, float z2,
+                int32_t x3, int32_t y3, float z3) {
+    int64_t area = edge_fixed_eval(x1, y1, x2, y2, x3, y3);
+    if (area <= 0) return 0;
+
+    const int32_t half = N_SUBPIXEL_ONE / 2;
+    t->xmin = MAX((MIN(MIN(x1, x2), x3) - half + N_SUBPIXEL_ONE - 1) >> N_SUBPIXEL_BITS, tg->x0);
+    t->xmax = MIN((MAX(MAX(x1, x2), x3) - half) >> N_SUBPIXEL_BITS, tg->x1);
+    t->ymin = MAX((MIN(MIN(y1, y2), y3) - half + N_SUBPIXEL_ONE - 1) >> N_SUBPIXEL_BITS, tg->y0);
+    t->ymax = MIN((MAX(MAX(y1, y2), y3) - half) >> N_SUBPIXEL_BITS, tg->y1);
+    if (t->xmin > t->xmax || t->ymin > t->ymax) return 0;
+
+    if (!edge_fixed_setup(&t->e[0], t, x2, y2, x3, y3, top_left(x3 - x2, y3 - y2)) ||
+        !edge_fixed_setup(&t->e[1], t, x3, y3, x1, y1, top_left(x1 - x3, y1 - y3)) ||
+        !edge_fixed_setup(&t->e[2], t, x1, y1, x2, y2, top_left(x2 - x1, y2 - y1))) {
+        return -1;
+    }
+
+    t->inv_area = 1.0f / (float)area;
+    depth_setup(&t->zbias, &t->zmin, &t->zmax, z1, z2, z3);
+    t->z1 = z1 * t->inv_area * depth_max(ctx.depth_format);
+    t->z2 = z2 * t->inv_area * depth_max(ctx.depth_format);
+    t->z3 = z3 * t->inv_area * depth_max(ctx.depth_format);
+    lazy_touch(tg->color, tg->depth, t->xmin, t->ymin, t->xmax, t->ymax);
+    return 1;
+}
+
+static INLINE int
+tri_fixed_covers(const tri_fixed_t* t, int x, int y) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        int32_t w = t->e[i].w + (x - t->xmin) * t->e[i].dx + (y - t->ymin) * t->e[i].dy;
+        if (!edge_fixed_inside(w, &t->e[i])) return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    int count;
+    int x[N_TRI_SMALL], y[N_TRI_SMALL];
+    int32_t a[N_TRI_SMALL], b[N_TRI_SMALL], g[N_TRI_SMALL];
+} tri_fixed_small_t;
+
+static INLINE int
+tri_fixed_is_small(const tri_fixed_t* t) {
+    return (t->xmax - t->xmin + 1) * (t->ymax - t->ymin + 1) <= N_TRI_SMALL;
+}
+
+static int
+tri_fixed_small_setup(tri_fixed_small_t* s, const tri_fixed_t* t) {
+    int x, y;
+    s->count = 0;
+    for (y = t->ymin; y <= t->ymax; y++) {
+        for (x = t->xmin; x <= t->xmax; x++) {
+            int32_t a = t->e[0].w + (x - t->xmin) * t->e[0].dx + (y - t->ymin) * t->e[0].dy;
+            int32_t b = t->e[1].w + (x - t->xmin) * t->e[1].dx + (y - t->ymin) * t->e[1].dy;
+            int32_t g = t->e[2].w + (x - t->xmin) * t->e[2].dx + (y - t->ymin) * t->e[2].dy;
+            if (!edge_fixed_inside(a, &t->e[0]) || !edge_fixed_inside(b, &t->e[1]) || !edge_fixed_inside(g, &t->e[2])) continue;
+            s->x[s->count] = x;
+            s->y[s->count] = y;
+            s->a[s->count] = a;
+            s->b[s->count] = b;
+            s->g[s->count] = g;
+            s->count++;
+        }
+    }
+    return s->count;
+}
+
+static INLINE int64_t
+fixed_floor_div(int64_t n, int64_t d) {
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+static INLINE int
+tri_fixed_row_range(const tri_fixed_t* t, int32_t a, int32_t b, int32_t g, int* x0, int* x1) {
+    int32_t w[3];
+    int64_t l = 0, r = t->xmax - t->xmin;
+    int i;
+    w[0] = a, w[1] = b, w[2] = g;
+    for (i = 0; i < 3; i++) {
+        const edge_fixed_t* e = &t->e[i];
+        if (e->dx > 0) l = MAX(l, fixed_floor_div((int64_t)e->thr - w[i], e->dx) + 1);
+        else if (e->dx < 0) r = MIN(r, fixed_floor_div((int64_t)w[i] - e->thr - 1, -(int64_t)e->dx));
+        else if (w[i] <= e->thr) return 0;
+    }
+    if (l > r) return 0;
+    *x0 = t->xmin + (int)l;
+    *x1 = t->xmin + (int)r;
+    return 1;
+}
+
+static void
+hiz_update_fixed(float* hz, const tri_fixed_t* t) {
+    int tx, ty;
+    for (ty = t->ymin / N_HIZ_SIZE; ty <= t->ymax / N_HIZ_SIZE; ty++) {
+        int y0 = ty * N_HIZ_SIZE;
+        int y1 = MIN(y0 + N_HIZ_SIZE - 1, ctx.height - 1);
+        for (tx = t->xmin / N_HIZ_SIZE; tx <= t->xmax / N_HIZ_SIZE; tx++) {
+            int x0 = tx * N_HIZ_SIZE;
+            int x1 = MIN(x0 + N_HIZ_SIZE - 1, ctx.width - 1);
+            float* z = &hz[ty * hiz.w + tx];
+
+            if (t->zmin <= *z) continue;
+            if (x0 < t->xmin || x1 > t->xmax || y0 < t->ymin || y1 > t->ymax) continue;
+            if (tri_fixed_covers(t, x0, y0) && tri_fixed_covers(t, x1, y0) &&
+                tri_fixed_covers(t, x0, y1) && tri_fixed_covers(t, x1, y1)) {
+                *z = t->zmin;
+            }
+        }
+    }
+}
+
+N_KERNEL void
+tri_fixed_kernel(const target_t* tg, const int fullrect, const int textured, const int wired, const void* texture,
+                 int32_t x1, int32_t y1, float z1, float w1, float u1, float v1,
+                 int32_t x2, int32_t y2, float z2, float w2, float u2, float v2,
+                 int32_t x3, int32_t y3, float z3, float w3, float u3, float v3,
+                 uint32_t final, const uint32_t* wire, const int tiled, const int format) {
+    tri_fixed_t t;
+    int x, y;
+
+    int ok = tri_fixed_setup(&t, tg, x1, y1, z1, x2, y2, z2, x3, y3, z3);
+    if (ok < 0) {
+        int ix1 = fixed_to_int(x1), iy1 = fixed_to_int(y1);
+        int ix2 = fixed_to_int(x2), iy2 = fixed_to_int(y2);
+        int ix3 = fixed_to_int(x3), iy3 = fixed_to_int(y3);
+        if (textured && fullrect) {
+            tri_tex_rect_draw(tg, texture, ix1, iy1, z1, w1, u1, v1, ix2, iy2, z2, w2, u2, v2, ix3, iy3, z3, w3, u3, v3);
+        } else if (textured) {
+            tri_tex_draw(tg, texture, ix1, iy1, z1, w1, u1, v1, ix2, iy2, z2, w2, u2, v2, ix3, iy3, z3, w3, u3, v3);
+        } else if (wired && fullrect) {
+            tri_fill_wire_rect_draw(tg, ix1, iy1, z1, ix2, iy2, z2, ix3, iy3, z3, final, wire);
+        } else if (wired) {
+            tri_fill_wire_draw(tg, ix1, iy1, z1, ix2, iy2, z2, ix3, iy3, z3, final, wire);
+        } else if (fullrect) {
+            tri_fill_rect_draw(tg, ix1, iy1, z1, ix2, iy2, z2, ix3, iy3, z3, final);
+        } else {
+            tri_fill_draw(tg, ix1, iy1, z1, ix2, iy2, z2, ix3, iy3, z3, final);
+        }
+        return;
+    }
+    if (!ok) return;
+
+    tri_fixed_small_t sm;
+    int small = !fullrect && tri_fixed_is_small(&t);
+    if (small && !tri_fixed_small_setup(&sm, &t)) return;
+
+    float* hz = fullrect || small ? 0 : hiz_get(tg);
+    if (hz && hiz_occluded(hz, t.xmin, t.ymin, t.xmax, t.ymax, t.zmax)) return;
+
+    float uw1 = u1 / w1, uw2 = u2 / w2, uw3 = u3 / w3;
+    float vw1 = v1 / w1, vw2 = v2 / w2, vw3 = v3 / w3;
+    float rw1 = 1.0f / w1, rw2 = 1.0f / w2, rw3 = 1.0f / w3;
+    uint32_t level = textured ? tex_level(texture, t.inv_area * (N_SUBPIXEL_ONE * N_SUBPIXEL_ONE),
+                                          u1, v1, u2, v2, u3, v3) : 0;
+    const int filter = ctx.tex_filter;
+
+    int32_t limit[3] = { 0, 0, 0 };
+    if (wired) {
+        limit[0] = edge_fixed_wire_limit(&t.e[0]);
+        limit[1] = edge_fixed_wire_limit(&t.e[1]);
+        limit[2] = edge_fixed_wire_limit(&t.e[2]);
+    }
+
+    if (small) {
+        int i;
+        for (i = 0; i < sm.count; i++) {
+            uint32_t* crow = tg->color + fb_row(sm.y[i], tiled);
+            void* drow = depth_ptr(tg->depth, fb_row(sm.y[i], tiled), format);
+            int ox = fb_col(sm.x[i], tiled);
+            int32_t a = sm.a[i], b = sm.b[i], g = sm.g[i];
+            float z = depth_quantize(t.zbias + (float)a * t.z1 + (float)b * t.z2 + (float)g * t.z3, format);
+            if (z < depth_load(drow, ox, format)) continue;
+
+            depth_store(drow, ox, z, format);
+            if (textured) {
+                float la = (float)a * t.inv_area;
+                float lb = (float)b * t.inv_area;
+                float lg = (float)g * t.inv_area;
+                float rw = la * rw1 + lb * rw2 + lg * rw3;
+                float u = (uw1 * la + uw2 * lb + uw3 * lg) / rw;
+                float v = (vw1 * la + vw2 * lb + vw3 * lg) / rw;
+                texture_sample_from_asset((const struct asset_texture_t*)texture, &u, &v, &crow[ox], 1, level, filter);
+            } else {
+                crow[ox] = final;
+            }
+            if (wired) crow[ox] = edge_fixed_wire_pick(limit, wire, a, b, g, crow[ox]);
+        }
+        return;
+    }
+
+    int large = !fullrect && t.xmax - t.xmin >= N_TRI_LARGE;
+
+#ifdef SIMD_WIDTH
+    vi_t step[3], thr[3];
+    int32_t ramp[SIMD_WIDTH];
+    int xa = t.xmin & ~(SIMD_WIDTH - 1);
+    int xb = tg->x1 - SIMD_WIDTH + 1;
+    int i;
+    for (i = 0; i < 3; i++) {
+        int k;
+        for (k = 0; k < SIMD_WIDTH; k++) ramp[k] = k * t.e[i].dx;
+        step[i] = vi_load(ramp);
+        thr[i] = vi_set1(t.e[i].thr);
+    }
+#endif
+
+    int32_t ra = t.e[0].w, rb = t.e[1].w, rg = t.e[2].w;
+
+    for (y = t.ymin; y <= t.ymax; y++, ra += t.e[0].dy, rb += t.e[1].dy, rg += t.e[2].dy) {
+        uint32_t* crow = tg->color + fb_row(y, tiled);
+        void* drow = depth_ptr(tg->depth, fb_row(y, tiled), format);
+        int32_t a, b, g;
+        int rx0 = t.xmin, rx1 = t.xmax;
+
+        if (large && !tri_fixed_row_range(&t, ra, rb, rg, &rx0, &rx1)) continue;
+
+        x = rx0;
+#ifdef SIMD_WIDTH
+        const float* hrow = hz ? hz + (y / N_HIZ_SIZE) * hiz.w : 0;
+        int xs = large ? rx0 & ~(SIMD_WIDTH - 1) : xa;
+
+        for (x = xs; x <= rx1 && x <= xb; x += SIMD_WIDTH) {
+            if (hrow && t.zmax < hrow[x / N_HIZ_SIZE]) continue;
+
+            vi_t va = vi_add(vi_set1(ra + (x - t.xmin) * t.e[0].dx), step[0]);
+            vi_t vb = vi_add(vi_set1(rb + (x - t.xmin) * t.e[1].dx), step[1]);
+            vi_t vg = vi_add(vi_set1(rg + (x - t.xmin) * t.e[2].dx), step[2]);
+            vf_t px = vf_add(vf_set1(x), vf_ramp());
+            vf_t range = vf_and(vf_ge(px, vf_set1(t.xmin)), vf_ge(vf_set1(t.xmax), px));
+
+            vf_t in = vf_and(vf_and(vi_gt(va, thr[0]), vi_gt(vb, thr[1])), vi_gt(vg, thr[2]));
+            in = vf_and(in, range);
+            if (!vf_mask(in)) continue;
+
+            vf_t fa = vi_to_vf(va), fb = vi_to_vf(vb), fg = vi_to_vf(vg);
+            vf_t z = vf_add(vf_add(vf_add(vf_set1(t.zbias), vf_mul(fa, vf_set1(t.z1))), vf_mul(fb, vf_set1(t.z2))), vf_mul(fg, vf_set1(t.z3)));
+            int ox = fb_col(x, tiled);
+            vf_t d = depth_load_v(drow, ox, format);
+            z = depth_quantize_v(z, format);
+            vf_t write = vf_and(in, vf_ge(z, d));
+
+            int mask = vf_mask(write);
+            if (!mask) continue;
+
+            uint32_t texels[SIMD_WIDTH];
+            if (textured) {
+                float us[SIMD_WIDTH], vs[SIMD_WIDTH];
+                vf_t la = vf_mul(fa, vf_set1(t.inv_area));
+                vf_t lb = vf_mul(fb, vf_set1(t.inv_area));
+                vf_t lg = vf_mul(fg, vf_set1(t.inv_area));
+                vf_t rw = vf_add(vf_add(vf_mul(la, vf_set1(rw1)), vf_mul(lb, vf_set1(rw2))), vf_mul(lg, vf_set1(rw3)));
+                vf_t u = vf_add(vf_add(vf_mul(vf_set1(uw1), la), vf_mul(vf_set1(uw2), lb)), vf_mul(vf_set1(uw3), lg));
+                vf_t v = vf_add(vf_add(vf_mul(vf_set1(vw1), la), vf_mul(vf_set1(vw2), lb)), vf_mul(vf_set1(vw3), lg));
+                vf_store(us, vf_and(vf_div(u, rw), write));
+                vf_store(vs, vf_and(vf_div(v, rw), write));
+                texture_sample_from_asset((const struct asset_texture_t*)texture, us, vs, texels, SIMD_WIDTH, level, filter);
+            }
+
+            vi_t fill = textured ? vi_load(texels) : vi_set1(final);
+            if (wired) {
+                fill = vi_select(vi_gt(vi_set1(limit[2]), vg), vi_set1(wire[2]), fill);
+                fill = vi_select(vi_gt(vi_set1(limit[1]), vb), vi_set1(wire[1]), fill);
+                fill = vi_select(vi_gt(vi_set1(limit[0]), va), vi_set1(wire[0]), fill);
+            }
+
+            depth_store_v(drow, ox, vf_select(write, z, d), format);
+            vi_store(crow + ox, vi_select(write, fill, vi_load(crow + ox)));
+        }
+        x = MAX(x, t.xmin);
+#endif
+        a = ra + (x - t.xmin) * t.e[0].dx;
+        b = rb + (x - t.xmin) * t.e[1].dx;
+        g = rg + (x - t.xmin) * t.e[2].dx;
+
+        for (; x <= rx1; x++, a += t.e[0].dx, b += t.e[1].dx, g += t.e[2].dx) {
+            if (!edge_fixed_inside(a, &t.e[0]) || !edge_fixed_inside(b, &t.e[1]) || !edge_fixed_inside(g, &t.e[2])) continue;
+            int ox = fb_col(x, tiled);
+
+            float z = depth_quantize(t.zbias + (float)a * t.z1 + (float)b * t.z2 + (float)g * t.z3, format);
+            if (z < depth_load(drow, ox, format)) continue;
+
+            depth_store(drow, ox, z, format);
+            if (textured) {
+                float la = (float)a * t.inv_area;
+                float lb = (float)b * t.inv_area;
+                float lg = (float)g * t.inv_area;
+                float rw = la * rw1 + lb * rw2 + lg * rw3;
+                float u = (uw1 * la + uw2 * lb + uw3 * lg) / rw;
+                float v = (vw1 * la + vw2 * lb + vw3 * lg) / rw;
+                texture_sample_from_asset((const struct asset_texture_t*)texture, &u, &v, &crow[ox], 1, level, filter);
+            } else {
+                crow[ox] = final;
+            }
+            if (wired) crow[ox] = edge_fixed_wire_pick(limit, wire, a, b, g, crow[ox]);
+        }
+    }
+
+    if (hz) hiz_update_fixed(hz, &t);
 }
 
-void
-n_flag_toggle(drawing_flags_t flag) {
-    flags ^= flag;
+static void
+tri_fixed_tex_draw(const target_t* tg, const void* texture,
+                   int32_t x1, int32_t y1, float z1, float w1, float u1, float v1,
+                   int32_t x2, int32_t y2, float z2, float w2, float u2, float v2,
+                   int32_t x3, int32_t y3, float z3, float w3, float u3, float v3,
+                   uint32_t final) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 0, 1, 0, texture,
+                     x1, y1, z1, w1, u1, v1,
+                     x2, y2, z2, w2, u2, v2,
+                     x3, y3, z3, w3, u3, v3,
+                     final, NULL)
 }
 
-void
-n_size_set(int width, int height) {
-    ctx.width = width;
-    ctx.height = height;
-    ctx.ox = width / 2;
-    ctx.oy = height / 2;
-    ctx.aspect = (float) height / width;
+static void
+tri_fixed_tex_rect_draw(const target_t* tg, const void* texture,
+                        int32_t x1, int32_t y1, float z1, float w1, float u1, float v1,
+                        int32_t x2, int32_t y2, float z2, float w2, float u2, float v2,
+                        int32_t x3, int32_t y3, float z3, float w3, float u3, float v3,
+                        uint32_t final) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 1, 1, 0, texture,
+                     x1, y1, z1, w1, u1, v1,
+                     x2, y2, z2, w2, u2, v2,
+                     x3, y3, z3, w3, u3, v3,
+                     final, NULL)
 }
 
-void
-n_clear_color_set(unsigned int color) {
-    ctx.clear_color = color;
+static void
+tri_fixed_fill_draw(const target_t* tg,
+                    int32_t x1, int32_t y1, float z1,
+                    int32_t x2, int32_t y2, float z2,
+                    int32_t x3, int32_t y3, float z3,
+                    uint32_t final) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 0, 0, 0, 0,
+                     x1, y1, z1, 1, 0, 0,
+                     x2, y2, z2, 1, 0, 0,
+                     x3, y3, z3, 1, 0, 0,
+                     final, NULL)
 }
 
-void
-n_clear(unsigned int* buffer, float* depth) {
-    unsigned int count = ctx.width * ctx.height;
-    int i;
-    for (i = 0; i < count; i++) {
-        buffer[i] = ctx.clear_color;
-    }
-    if (depth) {
-        int i;
-        for (i = 0; i < count; i++) {
-            depth[i] = -3.402823466e+38f;
-        }
-    }
+static void
+tri_fixed_fill_rect_draw(const target_t* tg,
+                         int32_t x1, int32_t y1, float z1,
+                         int32_t x2, int32_t y2, float z2,
+                         int32_t x3, int32_t y3, float z3,
+                         uint32_t final) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 1, 0, 0, 0,
+                     x1, y1, z1, 1, 0, 0,
+                     x2, y2, z2, 1, 0, 0,
+                     x3, y3, z3, 1, 0, 0,
+                     final, NULL)
 }
 
-int n_point_draw(unsigned int* buffer, unsigned int x, unsigned int y, unsigned int color) {
-    if (y * ctx.width + x < 0 || y * ctx.width + x > (ctx.width * ctx.height)) return 0;
-    buffer[y * ctx.width + x] = color;
-    return 1;
+static void
+tri_fixed_fill_wire_draw(const target_t* tg,
+                         int32_t x1, int32_t y1, float z1,
+                         int32_t x2, int32_t y2, float z2,
+                         int32_t x3, int32_t y3, float z3,
+                         uint32_t final, const uint32_t* wire) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 0, 0, 1, 0,
+                     x1, y1, z1, 1, 0, 0,
+                     x2, y2, z2, 1, 0, 0,
+                     x3, y3, z3, 1, 0, 0,
+                     final, wire)
 }
 
-int n_depth_set(float* buffer, unsigned int x, unsigned int y, float depth) {
-    if (depth >= buffer[y * ctx.width + x]) {
-        buffer[y * ctx.width + x] = depth;
-        return 1;
-    }
-    return 0;
+static void
+tri_fixed_fill_wire_rect_draw(const target_t* tg,
+                              int32_t x1, int32_t y1, float z1,
+                              int32_t x2, int32_t y2, float z2,
+                              int32_t x3, int32_t y3, float z3,
+                              uint32_t final, const uint32_t* wire) {
+    N_TARGET_DISPATCH(tri_fixed_kernel, tg, 1, 0, 1, 0,
+                     x1, y1, z1, 1, 0, 0,
+                     x2, y2, z2, 1, 0, 0,
+                     x3, y3, z3, 1, 0, 0,
+                     final, wire)
 }
 
+static INLINE uint32_t
+wire_color(int32_t ax, int32_t ay, uint32_t ca, int32_t bx, int32_t by, uint32_t cb) {
+    return 0xffffffff - ((ay < by || (ay == by && ax < bx)) ? ca : cb);
+}
 
-void
-n_line2d_draw(unsigned int* buffer, int x1, int y1, int x2, int y2, unsigned int color)
-{
-    int dx = mm_abs(x2 - x1);
-    int sx = x1 < x2 ? 1 : -1;
-    int dy = -mm_abs(y2 - y1);
-    int sy = y1 < y2 ? 1 : -1;
-    int error = dx + dy;
-
-    while (1)
-    {
-        if (!n_point_draw(buffer, x1, y1, color)) return;
+typedef void (*triangle_kernel_t)(const target_t* tg, const void* texture,
+                                  float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1,
+                                  float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2,
+                                  float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3);
+
+N_KERNEL void
+triangle_pipeline(const target_t* tg, const void* texture,
+                  float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1,
+                  float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2,
+                  float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3,
+                  const int f) {
+    int32_t fx1 = 0, fy1 = 0, fx2 = 0, fy2 = 0, fx3 = 0, fy3 = 0;
+    int px1, py1, px2, py2, px3, py3;
+    int shade = f & DRAW_FLAG_SHADE;
+    int wire = f & DRAW_FLAG_WIREFRAME;
+    int dot = f & DRAW_FLAG_DOT;
+    int rect = f & DRAW_FLAG_FULLRECT;
+
+    if (f & DRAW_FLAG_SUBPIXEL) {
+        fx1 = fixed_from_float(x1), fy1 = fixed_from_float(y1);
+        fx2 = fixed_from_float(x2), fy2 = fixed_from_float(y2);
+        fx3 = fixed_from_float(x3), fy3 = fixed_from_float(y3);
+        px1 = fixed_to_int(fx1), py1 = fixed_to_int(fy1);
+        px2 = fixed_to_int(fx2), py2 = fixed_to_int(fy2);
+        px3 = fixed_to_int(fx3), py3 = fixed_to_int(fy3);
+    } else {
+        px1 = (int)x1, py1 = (int)y1;
+        px2 = (int)x2, py2 = (int)y2;
+        px3 = (int)x3, py3 = (int)y3;
+    }
 
-        if (x1 == x2 && y1 == y2) break;
-        int e2 = 2 * error;
+    v1 = 1.0 - v1;
+    v2 = 1.0 - v2;
+    v3 = 1.0 - v3;
 
-        if (e2 >= dy)
-        {
-            if (x1 == x2) break;
-            error = error + dy;
-            x1 = x1 + sx;
+    if (shade && !wire && !dot) {
+        if (!(f & DRAW_FLAG_SUBPIXEL)) {
+            (rect ? tri_tex_rect_draw : tri_tex_draw)(tg, texture,
+                px1, py1, z1, w1, u1, v1,
+                px2, py2, z2, w2, u2, v2,
+                px3, py3, z3, w3, u3, v3);
+        } else if (texture) {
+            (rect ? tri_fixed_tex_rect_draw : tri_fixed_tex_draw)(tg, texture,
+                fx1, fy1, z1, w1, u1, v1,
+                fx2, fy2, z2, w2, u2, v2,
+                fx3, fy3, z3, w3, u3, v3,
+                n_color_mix3(c1, c2, c3));
+        } else {
+            (rect ? tri_fixed_fill_rect_draw : tri_fixed_fill_draw)(tg,
+                fx1, fy1, z1, fx2, fy2, z2, fx3, fy3, z3,
+                n_color_mix3(c1, c2, c3));
         }
-
-        if (e2 <= dx)
-        {
-            if (y1 == y2) break;
-            error = error + dx;
-            y1 = y1 + sy;
+    } else if (shade && wire) {
+        uint32_t edge[3];
+        if (f & DRAW_FLAG_SUBPIXEL) {
+            edge[0] = wire_color(fx2, fy2, c2, fx3, fy3, c3);
+            edge[1] = wire_color(fx3, fy3, c3, fx1, fy1, c1);
+            edge[2] = wire_color(fx1, fy1, c1, fx2, fy2, c2);
+            (rect ? tri_fixed_fill_wire_rect_draw : tri_fixed_fill_wire_draw)(tg,
+                fx1, fy1, z1, fx2, fy2, z2, fx3, fy3, z3,
+                n_color_mix3(c1, c2, c3), edge);
+        } else {
+            edge[0] = wire_color(px2, py2, c2, px3, py3, c3);
+            edge[1] = wire_color(px3, py3, c3, px1, py1, c1);
+            edge[2] = wire_color(px1, py1, c1, px2, py2, c2);
+            (rect ? tri_fill_wire_rect_draw : tri_fill_wire_draw)(tg,
+                px1, py1, z1, px2, py2, z2, px3, py3, z3,
+                n_color_mix3(c1, c2, c3), edge);
+        }
+    } else if (shade) {
+        if (f & DRAW_FLAG_SUBPIXEL) {
+            (rect ? tri_fixed_fill_rect_draw : tri_fixed_fill_draw)(tg,
+                fx1, fy1, z1, fx2, fy2, z2, fx3, fy3, z3,
+                n_color_mix3(c1, c2, c3));
+        } else {
+            (rect ? tri_fill_rect_draw : tri_fill_draw)(tg,
+                px1, py1, z1, px2, py2, z2, px3, py3, z3,
+                n_color_mix3(c1, c2, c3));
         }
     }
-}
 
-void
-n_line2d_draw_gradient(unsigned int* buffer, int x1, int y1, int x2, int y2, unsigned int color1, unsigned int color2)
-{
-    int dx = mm_abs(x2 - x1);
-    int sx = x1 < x2 ? 1 : -1;
-    int dy = -mm_abs(y2 - y1);
-    int sy = y1 < y2 ? 1 : -1;
-    int error = dx + dy;
-
-    /* Calculate total distance for interpolation */
-    float total_distance = mm_sqrt((float)(dx * dx + dy * dy));
-    if (total_distance == 0.0f) {
-        n_point_draw(buffer, x1, y1, color1);
-        return;
+    if (shade && wire && dot) {
+        tri_dots_draw(tg, px1, py1, px2, py2, px3, py3, 0xff66ff66 - c1);
+    } else if (shade && dot) {
+        tri_dots_draw(tg, px1, py1, px2, py2, px3, py3, 0xffffffff - c1);
+    } else if (wire && dot) {
+        tri_wire_draw(tg, px1, py1, px2, py2, px3, py3, c1);
+        tri_dots_draw(tg, px1, py1, px2, py2, px3, py3, 0xffffffff - c1);
+    } else if (wire) {
+        tri_wire_draw(tg, px1, py1, px2, py2, px3, py3, c1);
+    } else if (dot) {
+        tri_dots_draw(tg, px1, py1, px2, py2, px3, py3, c1);
     }
+}
 
-    /* Extract color components */
-    color_t c1 = { color1 };
-    color_t c2 = { color2 };
+#define N_KERNEL_VARIANT(shade, wire, dot, rect, sub) \
+static void \
+triangle_kernel_##shade##wire##dot##rect##sub(const target_t* tg, const void* texture, \
+    float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1, \
+    float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2, \
+    float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3) { \
+    triangle_pipeline(tg, texture, \
+                      x1, y1, z1, w1, u1, v1, c1, \
+                      x2, y2, z2, w2, u2, v2, c2, \
+                      x3, y3, z3, w3, u3, v3, c3, \
+                      (shade ? DRAW_FLAG_SHADE : 0) | (wire ? DRAW_FLAG_WIREFRAME : 0) | \
+                      (dot ? DRAW_FLAG_DOT : 0) | (rect ? DRAW_FLAG_FULLRECT : 0) | \
+                      (sub ? DRAW_FLAG_SUBPIXEL : 0)); \
+}
+#include "nude_kernels.inc"
+#undef N_KERNEL_VARIANT
 
-    int start_x = x1;
-    int start_y = y1;
+static const triangle_kernel_t kernels[] = {
+#define N_KERNEL_VARIANT(shade, wire, dot, rect, sub) triangle_kernel_##shade##wire##dot##rect##sub,
+#include "nude_kernels.inc"
+#undef N_KERNEL_VARIANT
+};
 
-    while (1)
-    {
-        /* Calculate interpolation factor based on distance from start */
-        int dist_x = x1 - start_x;
-        int dist_y = y1 - start_y;
-        float current_distance = mm_sqrt((float)(dist_x * dist_x + dist_y * dist_y));
-        float t = current_distance / total_distance;
+void
+n_triangle_draw(uint32_t* color, void* depth, const void* texture,
+                int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1,
+                int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2,
+                int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3) {
+    target_t tg = target_full(color, depth);
+    kernels[N_KERNEL_KEY(flags & ~DRAW_FLAG_SUBPIXEL)](&tg, texture,
+                                                       x1, y1, z1, w1, u1, v1, c1,
+                                                       x2, y2, z2, w2, u2, v2, c2,
+                                                       x3, y3, z3, w3, u3, v3, c3);
+}
 
-        /* Interpolate color components */
-        color_t current_color;
-        current_color.r = (uint8_t)lerp((float)c1.r, (float)c2.r, t);
-        current_color.g = (uint8_t)lerp((float)c1.g, (float)c2.g, t);
-        current_color.b = (uint8_t)lerp((float)c1.b, (float)c2.b, t);
-        current_color.a = (uint8_t)lerp((float)c1.a, (float)c2.a, t);
+void
+n_triangle_draw_subpixel(uint32_t* color, void* depth, const void* texture,
+                         float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1,
+                         float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2,
+                         float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3) {
+    target_t tg = target_full(color, depth);
+    kernels[N_KERNEL_KEY(flags | DRAW_FLAG_SUBPIXEL)](&tg, texture,
+                                                      x1, y1, z1, w1, u1, v1, c1,
+                                                      x2, y2, z2, w2, u2, v2, c2,
+                                                      x3, y3, z3, w3, u3, v3, c3);
+}
 
-        if (!n_point_draw(buffer, x1, y1, current_color.hex)) return;
+typedef struct {
+    float x, y;
+    float z, w, u, v;
+    uint32_t c;
+} raster_vertex_t;
 
-        if (x1 == x2 && y1 == y2) break;
-        int e2 = 2 * error;
+typedef struct {
+    const void* texture;
+    raster_vertex_t v[3];
+    int tx0, ty0, tx1, ty1;
+} raster_tri_t;
 
-        if (e2 >= dy)
-        {
-            if (x1 == x2) break;
-            error = error + dy;
-            x1 = x1 + sx;
-        }
+static struct {
+    int recording;
+    triangle_kernel_t kernel;
+    uint32_t* color;
+    void* depth;
+    int tiles_x, tiles_y;
+    raster_tri_t* tris;
+    int tris_count;
+    int tris_capacity;
+    int* refs;
+    int refs_capacity;
+    int* tiles;
+    int tiles_capacity;
+    int* tile_start;
+    int* tile_fill;
+} bins;
 
-        if (e2 <= dx)
-        {
-            if (y1 == y2) break;
-            error = error + dx;
-            y1 = y1 + sy;
-        }
-    }
+void
+nude_threads_set(int count) {
+    x_jobs_init(MAX(count, 1) - 1);
 }
 
-void n_texture_draw(uint32_t* buffer, int w, int h) {
-    int x, y;
-    for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
-            n_point_draw(buffer, x, y, texture_get_color((float)x / w, (float)y / h));
-        }
-    }
+static void
+bins_reserve(void** block, int* capacity, int count, int size) {
+    if (count <= *capacity) return;
+    int new_capacity = MAX(*capacity * 2, MAX(count, 64));
+    *block = *block ? x_realloc(*block, (uint64_t)size * new_capacity, 0)
+                    : x_alloc((uint64_t)size * new_capacity, 0);
+    *capacity = new_capacity;
 }
 
-void
-n_grid_line_draw(uint32_t* buffer, int w, int h, int size) {
-    int x, y;
-    for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
-            if (x % size == 0 || y % size == 0) {
-                n_point_draw(buffer, x, y, 0xff333333);
-            }
-        }
+static void
+bins_begin(uint32_t* color, void* depth) {
+    bins.recording = 1;
+    bins.kernel = kernels[N_KERNEL_KEY(flags)];
+    bins.color = color;
+    bins.depth = depth;
+    bins.tiles_x = (ctx.width + N_TILE_SIZE - 1) / N_TILE_SIZE;
+    bins.tiles_y = (ctx.height + N_TILE_SIZE - 1) / N_TILE_SIZE;
+    bins.tris_count = 0;
+}
+
+static void
+triangle_emit(uint32_t* color, void* depth, triangle_kernel_t kernel, const void* texture,
+              float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1,
+              float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2,
+              float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3) {
+    if (!bins.recording) {
+        target_t tg = target_full(color, depth);
+        kernel(&tg, texture,
+               x1, y1, z1, w1, u1, v1, c1,
+               x2, y2, z2, w2, u2, v2, c2,
+               x3, y3, z3, w3, u3, v3, c3);
+        return;
     }
+
+    int xmin = MAX((int)mm_floor(MIN(MIN(x1, x2), x3)), 0);
+    int ymin = MAX((int)mm_floor(MIN(MIN(y1, y2), y3)), 0);
+    int xmax = MIN((int)MAX(MAX(x1, x2), x3) + 4, ctx.width - 1);
+    int ymax = MIN((int)MAX(MAX(y1, y2), y3) + 4, ctx.height - 1);
+    if (xmin > xmax || ymin > ymax) return;
+
+    bins_reserve((void**)&bins.tris, &bins.tris_capacity, bins.tris_count + 1, sizeof(raster_tri_t));
+
+    raster_tri_t* t = &bins.tris[bins.tris_count++];
+    t->texture = texture;
+    t->v[0] = (raster_vertex_t) { x1, y1, z1, w1, u1, v1, c1 };
+    t->v[1] = (raster_vertex_t) { x2, y2, z2, w2, u2, v2, c2 };
+    t->v[2] = (raster_vertex_t) { x3, y3, z3, w3, u3, v3, c3 };
+    t->tx0 = xmin / N_TILE_SIZE;
+    t->ty0 = ymin / N_TILE_SIZE;
+    t->tx1 = xmax / N_TILE_SIZE;
+    t->ty1 = ymax / N_TILE_SIZE;
 }
 
-void
-n_grid_dot_draw(uint32_t* buffer,
-                int w, int h,
-                int size, float time) {
-    int x, y;
-    for (y = size / 2; y < h; y+=size) {
-        for (x = size / 2; x < w; x+=size) {
-            vec2_t color_pos = {{ x * 0.02 + time, y * 0.02 + time }};
-            float ratio = mm_noise2d(color_pos.x, color_pos.y, 0);
-            union {
-                uint8_t data[4];
-                uint32_t hex;
-            } color = {{
-                ratio * 255.0f,
-                ratio * 255.0f,
-                ratio * 255.0f,
-                0xff,
-            }};
-            n_point_draw(buffer, x, y, color.hex);
-        }
+static struct {
+    int active;
+    uint32_t* ids;
+    int capacity;
+} vis;
+
+typedef struct {
+    const raster_tri_t* t;
+    int fixed;
+    tri_setup_t s;
+    tri_fixed_t f;
+    tex_persp_t persp;
+    float rw[3];
+    uint32_t level;
+} vis_tri_t;
+
+static void
+vis_raster(const target_t* tg, const raster_tri_t* t, uint32_t id) {
+    if (flags & DRAW_FLAG_SUBPIXEL) {
+        tri_fixed_fill_draw(tg,
+                            fixed_from_float(t->v[0].x), fixed_from_float(t->v[0].y), t->v[0].z,
+                            fixed_from_float(t->v[1].x), fixed_from_float(t->v[1].y), t->v[1].z,
+                            fixed_from_float(t->v[2].x), fixed_from_float(t->v[2].y), t->v[2].z,
+                            id);
+    } else {
+        tri_fill_draw(tg,
+                      t->v[0].x, t->v[0].y, t->v[0].z,
+                      t->v[1].x, t->v[1].y, t->v[1].z,
+                      t->v[2].x, t->v[2].y, t->v[2].z,
+                      id);
     }
 }
 
-void
-n_rect_fill_draw(uint32_t* buffer, int sx, int sy, int width, int height, uint32_t color) {
-    int x, y;
-    for (y = sy; y < sy + height; y++) {
-        for (x = sx; x < sx + width; x++) {
-            n_point_draw(buffer, x, y, color);
+static void
+vis_tri_setup(vis_tri_t* vt, const target_t* tg, const raster_tri_t* t) {
+    int i;
+    vt->t = t;
+    vt->fixed = 0;
+
+    if (flags & DRAW_FLAG_SUBPIXEL) {
+        int32_t x[3], y[3];
+        for (i = 0; i < 3; i++) {
+            x[i] = fixed_from_float(t->v[i].x);
+            y[i] = fixed_from_float(t->v[i].y);
+        }
+        vt->fixed = tri_fixed_setup(&vt->f, tg, x[0], y[0], t->v[0].z, x[1], y[1], t->v[1].z, x[2], y[2], t->v[2].z) > 0;
+        if (!vt->fixed) {
+            tri_setup(&vt->s, tg,
+                      fixed_to_int(x[0]), fixed_to_int(y[0]), t->v[0].z,
+                      fixed_to_int(x[1]), fixed_to_int(y[1]), t->v[1].z,
+                      fixed_to_int(x[2]), fixed_to_int(y[2]), t->v[2].z);
         }
+    } else {
+        tri_setup(&vt->s, tg,
+                  t->v[0].x, t->v[0].y, t->v[0].z,
+                  t->v[1].x, t->v[1].y, t->v[1].z,
+                  t->v[2].x, t->v[2].y, t->v[2].z);
     }
-}
 
-void
-n_triangle_dots_draw(uint32_t* buffer,
-                     float x1, float y1,
-                     float x2, float y2,
-                     float x3, float y3,
-                     uint32_t color) {
-    n_rect_fill_draw(buffer, x1, y1, 4, 4, color);
-    n_rect_fill_draw(buffer, x2, y2, 4, 4, color);
-    n_rect_fill_draw(buffer, x3, y3, 4, 4, color);
+    float v[3];
+    for (i = 0; i < 3; i++) {
+        v[i] = 1.0 - t->v[i].v;
+        vt->rw[i] = 1.0f / t->v[i].w;
+    }
+    tex_persp_setup(&vt->persp, vt->fixed ? vt->f.inv_area : vt->s.inv_area,
+                    t->v[0].w, t->v[0].u, v[0],
+                    t->v[1].w, t->v[1].u, v[1],
+                    t->v[2].w, t->v[2].u, v[2]);
+    vt->level = tex_level(t->texture,
+                          vt->fixed ? vt->f.inv_area * (N_SUBPIXEL_ONE * N_SUBPIXEL_ONE) : vt->s.inv_area,
+                          t->v[0].u, t->v[0].v, t->v[1].u, t->v[1].v, t->v[2].u, t->v[2].v);
 }
 
-void
-n_triangle_wire_draw(uint32_t* buffer,
-                     float x1, float y1,
-                     float x2, float y2,
-                     float x3, float y3,
-                     uint32_t color) {
-    n_line2d_draw(buffer, x1, y1, x2, y2, color);
-    n_line2d_draw(buffer, x2, y2, x3, y3, color);
-    n_line2d_draw(buffer, x3, y3, x1, y1, color);
+static uint32_t
+vis_tri_shade(const vis_tri_t* vt, int x, int y) {
+    float la, lb, lg, rw, u, v;
+
+    if (vt->fixed) {
+        const tri_fixed_t* f = &vt->f;
+        int32_t a = f->e[0].w + (x - f->xmin) * f->e[0].dx + (y - f->ymin) * f->e[0].dy;
+        int32_t b = f->e[1].w + (x - f->xmin) * f->e[1].dx + (y - f->ymin) * f->e[1].dy;
+        int32_t g = f->e[2].w + (x - f->xmin) * f->e[2].dx + (y - f->ymin) * f->e[2].dy;
+        la = (float)a * f->inv_area;
+        lb = (float)b * f->inv_area;
+        lg = (float)g * f->inv_area;
+        rw = la * vt->rw[0] + lb * vt->rw[1] + lg * vt->rw[2];
+        u = (vt->persp.uw[0] * la + vt->persp.uw[1] * lb + vt->persp.uw[2] * lg) / rw;
+        v = (vt->persp.vw[0] * la + vt->persp.vw[1] * lb + vt->persp.vw[2] * lg) / rw;
+    } else {
+        const tri_setup_t* s = &vt->s;
+        float a = s->e[0].w + (x - s->xmin) * s->e[0].dx + (y - s->ymin) * s->e[0].dy;
+        float b = s->e[1].w + (x - s->xmin) * s->e[1].dx + (y - s->ymin) * s->e[1].dy;
+        float g = s->e[2].w + (x - s->xmin) * s->e[2].dx + (y - s->ymin) * s->e[2].dy;
+        tex_persp(&vt->persp, a, b, g, &u, &v);
+    }
+    uint32_t color;
+    texture_sample_from_asset((const struct asset_texture_t*)vt->t->texture, &u, &v, &color, 1, vt->level, ctx.tex_filter);
+    return color;
 }
 
-uint32_t
-n_color_percent(uint32_t color,
-                float precent) {
-    color_t c = { color };
-    c.r *= precent;
-    c.g *= precent;
-    c.b *= precent;
-    return c.hex;
-}
+static void
+vis_tile_draw(const target_t* tg, int index) {
+    target_t ids = *tg;
+    vis_tri_t vt;
+    uint32_t last = 0;
+    int i, x, y;
 
-uint32_t
-n_color_mix3(uint32_t c1, uint32_t c2, uint32_t c3) {
-    const float p = 1.0f / 3.0f;
-    color_t c11 = { c1 };
-    color_t c22 = { c2 };
-    color_t c33 = { c3 };
-    c11.r *= p; c11.g *= p; c11.b *= p; c11.a = 0;
-    c22.r *= p; c22.g *= p; c22.b *= p; c22.a = 0;
-    c33.r *= p; c33.g *= p; c33.b *= p; c33.a = 0;
-    return 0xff000000 | ( c11.hex + c22.hex + c33.hex );
-}
+    int band = ctx.fb_tiled ? N_FB_TILE : 1;
 
-void
-n_triangle_tex_draw(uint32_t* color, float* depth, const void* texture,
-                    int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1,
-                    int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2,
-                    int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3) {
-    int x, y;
-    float area = edge_function_bar(x1, y1, x2, y2, x3, y3);
-    if (area == 0.0f) return;
-
-    int xmin = MIN(MIN(x1, x2), x3);
-    int xmax = MAX(MAX(x1, x2), x3);
-    int ymin = MIN(MIN(y1, y2), y3);
-    int ymax = MAX(MAX(y1, y2), y3);
-
-    float e1x = x2 - x1, e1y = y2 - y1;
-    float e2x = x3 - x2, e2y = y3 - y2;
-    float e3x = x1 - x3, e3y = y1 - y3;
-
-    for (y = ymin; y < ymax + 1; y++) {
-        for (x = xmin; x < xmax + 1; x++) {
-            float px = x + 0.5f;
-            float py = y + 0.5f;
-            float a, b, g;
-
-            a = edge_function_bar(x2, y2, x3, y3, px, py);
-            b = edge_function_bar(x3, y3, x1, y1, px, py);
-            g = edge_function_bar(x1, y1, x2, y2, px, py);
-
-            int overlaps = 1;
-            overlaps &= (a > 0 || (a == 0 && top_left(e1x, e1y)));
-            overlaps &= (b > 0 || (b == 0 && top_left(e2x, e2y)));
-            overlaps &= (g > 0 || (g == 0 && top_left(e3x, e3y)));
-
-            if (overlaps) {
-                a /= area;
-                b /= area;
-                g /= area;
-
-                float z = 0.5f + (z1 * a) + (z2 * b) + (z3 * g);
-
-                if (n_depth_set(depth, x, y, z)) {
-                    float rw = a / w1 + b / w2 + g / w3;
-                    float u = (u1 / w1 * a + u2 / w2 * b + u3 / w3 * g) / rw;
-                    float v = (v1 / w1 * a + v2 / w2 * b + v3 / w3 * g) / rw;
-                    uint32_t final = texture_get_color_from_asset((const struct asset_texture_t*)texture, u, v);
-                    n_point_draw(color, x, y, final);
-                }
-            } else if (flags & DRAW_FLAG_FULLRECT) {
-                a /= area;
-                b /= area;
-                g /= area;
+    ids.color = vis.ids;
+    for (y = tg->y0; y <= tg->y1; y += band) {
+        x_mem_zero(vis.ids + fb_index(tg->x0, y), sizeof(uint32_t) * (tg->x1 - tg->x0 + 1) * band);
+    }
 
-                float z = 0.5f + (z1 * a) + (z2 * b) + (z3 * g);
+    for (i = bins.tile_start[index]; i < bins.tile_start[index + 1]; i++) {
+        vis_raster(&ids, &bins.tris[bins.refs[i]], bins.refs[i] + 1);
+    }
 
-                if (n_depth_set(depth, x, y, z)) {
-                    n_point_draw(color, x, y, 0xff00ff00);
-                }
+    for (y = tg->y0; y <= tg->y1; y++) {
+        for (x = tg->x0; x <= tg->x1; x++) {
+            uint32_t id = vis.ids[fb_index(x, y)];
+            if (!id) continue;
+            if (id != last) {
+                vis_tri_setup(&vt, tg, &bins.tris[id - 1]);
+                last = id;
             }
+            tg->color[fb_index(x, y)] = vis_tri_shade(&vt, x, y);
         }
     }
 }
 
-void
-n_triangle_fill_draw(uint32_t* color, float* depth,
-                     int x1, int y1, float z1, uint32_t c1,
-                     int x2, int y2, float z2, uint32_t c2,
-                     int x3, int y3, float z3, uint32_t c3) {
-    float area = edge_function_bar(x1, y1, x2, y2, x3, y3);
-    if (area == 0.0f) return;
+static void
+bins_tile_job(void* user, int index) {
+    int tx = index % bins.tiles_x;
+    int ty = index / bins.tiles_x;
+    target_t tg = {
+        bins.color, bins.depth,
+        tx * N_TILE_SIZE, ty * N_TILE_SIZE,
+        MIN(tx * N_TILE_SIZE + N_TILE_SIZE - 1, ctx.width - 1),
+        MIN(ty * N_TILE_SIZE + N_TILE_SIZE - 1, ctx.height - 1)
+    };
+    int i;
 
-    int xmin = MIN(MIN(x1, x2), x3);
-    int xmax = MAX(MAX(x1, x2), x3);
-    int ymin = MIN(MIN(y1, y2), y3);
-    int ymax = MAX(MAX(y1, y2), y3);
+    (void)user;
 
-    float e1x = x2 - x1, e1y = y2 - y1;
-    float e2x = x3 - x2, e2y = y3 - y2;
-    float e3x = x1 - x3, e3y = y1 - y3;
+    if (bins.tile_start[index] < bins.tile_start[index + 1]) {
+        lazy_touch(tg.color, tg.depth, tg.x0, tg.y0, tg.x1, tg.y1);
+    }
 
-    int x, y;
-    for (y = ymin; y < ymax + 1; y++) {
-        for (x = xmin; x < xmax + 1; x++) {
-            float px = x + 0.5f;
-            float py = y + 0.5f;
-            float a, b, g;
-
-            a = edge_function_bar(x2, y2, x3, y3, px, py);
-            b = edge_function_bar(x3, y3, x1, y1, px, py);
-            g = edge_function_bar(x1, y1, x2, y2, px, py);
-
-            int overlaps = 1;
-            overlaps &= (a > 0 || (a == 0 && top_left(e1x, e1y)));
-            overlaps &= (b > 0 || (b == 0 && top_left(e2x, e2y)));
-            overlaps &= (g > 0 || (g == 0 && top_left(e3x, e3y)));
-
-            if (overlaps) {
-                a /= area;
-                b /= area;
-                g /= area;
-
-                float z = 0.5f + (z1 * a) + (z2 * b) + (z3 * g);
-
-                if (n_depth_set(depth, x, y, z)) {
-                    color_t final = { n_color_mix3(c1, c2, c3) };
-                    n_point_draw(color, x, y, final.hex);
-                }
-            } else if (flags & DRAW_FLAG_FULLRECT) {
-                a /= area;
-                b /= area;
-                g /= area;
+    if (vis.active) {
+        vis_tile_draw(&tg, index);
+        return;
+    }
 
-                float z = 0.5f + (z1 * a) + (z2 * b) + (z3 * g);
+    for (i = bins.tile_start[index]; i < bins.tile_start[index + 1]; i++) {
+        const raster_tri_t* t = &bins.tris[bins.refs[i]];
+        bins.kernel(&tg, t->texture,
+                    t->v[0].x, t->v[0].y, t->v[0].z, t->v[0].w, t->v[0].u, t->v[0].v, t->v[0].c,
+                    t->v[1].x, t->v[1].y, t->v[1].z, t->v[1].w, t->v[1].u, t->v[1].v, t->v[1].c,
+                    t->v[2].x, t->v[2].y, t->v[2].z, t->v[2].w, t->v[2].u, t->v[2].v, t->v[2].c);
+    }
+}
 
-                if (n_depth_set(depth, x, y, z)) {
-                    n_point_draw(color, x, y, 0xff00ff00);
-                }
+static void
+bins_flush(int visibility) {
+    int tiles = bins.tiles_x * bins.tiles_y;
+    int i, tx, ty, total = 0;
+
+    bins.recording = 0;
+    vis.active = visibility;
+    if (visibility) {
+        bins_reserve((void**)&vis.ids, &vis.capacity, ctx.width * ctx.height, sizeof(uint32_t));
+    }
+
+    bins_reserve((void**)&bins.tiles, &bins.tiles_capacity, 2 * (tiles + 1), sizeof(int));
+    bins.tile_start = bins.tiles;
+    bins.tile_fill = bins.tiles + tiles + 1;
+    x_mem_zero(bins.tile_fill, sizeof(int) * tiles);
+
+    for (i = 0; i < bins.tris_count; i++) {
+        const raster_tri_t* t = &bins.tris[i];
+        for (ty = t->ty0; ty <= t->ty1; ty++) {
+            for (tx = t->tx0; tx <= t->tx1; tx++) {
+                bins.tile_fill[ty * bins.tiles_x + tx]++;
             }
         }
     }
-}
 
-void int_swap(int* a, int* b) {
-    int tmp = *a;
-    *a = *b;
-    *b = tmp;
-}
-
-void float_swap(float* a, float* b) {
-    float tmp = *a;
-    *a = *b;
-    *b = tmp;
-}
+    for (i = 0; i < tiles; i++) {
+        bins.tile_start[i] = total;
+        total += bins.tile_fill[i];
+        bins.tile_fill[i] = bins.tile_start[i];
+    }
+    bins.tile_start[tiles] = total;
 
-void
-n_triangle_draw(uint32_t* color, float* depth, const void* texture,
-                int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1,
-                int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2,
-                int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3) {
-    v1 = 1.0 - v1;
-    v2 = 1.0 - v2;
-    v3 = 1.0 - v3;
+    bins_reserve((void**)&bins.refs, &bins.refs_capacity, total, sizeof(int));
 
-    if (flags & DRAW_FLAG_SHADE && flags & DRAW_FLAG_WIREFRAME && flags & DRAW_FLAG_DOT) {
-        n_triangle_fill_draw(color, depth,
-                             x1, y1, z1, c1,
-                             x2, y2, z2, c2,
-                             x3, y3, z3, c3);
-        n_triangle_wire_draw(color, x1, y1, x2, y2, x3, y3, 0xffffffff - c1);
-        n_triangle_dots_draw(color, x1, y1, x2, y2, x3, y3, 0xff66ff66 - c1);
-    } else if (flags & DRAW_FLAG_SHADE && flags & DRAW_FLAG_WIREFRAME) {
-        n_triangle_fill_draw(color, depth,
-                             x1, y1, z1, c1,
-                             x2, y2, z2, c2,
-                             x3, y3, z3, c3);
-        n_triangle_wire_draw(color, x1, y1, x2, y2, x3, y3, 0xffffffff - c1);
-    } else if (flags & DRAW_FLAG_SHADE && flags & DRAW_FLAG_DOT) {
-        n_triangle_fill_draw(color, depth,
-                             x1, y1, z1, c1,
-                             x2, y2, z2, c2,
-                             x3, y3, z3, c3);
-        n_triangle_dots_draw(color, x1, y1, x2, y2, x3, y3, 0xffffffff - c1);
-    } else if (flags & DRAW_FLAG_WIREFRAME && flags & DRAW_FLAG_DOT) {
-        n_triangle_wire_draw(color, x1, y1, x2, y2, x3, y3, c1);
-        n_triangle_dots_draw(color, x1, y1, x2, y2, x3, y3, 0xffffffff - c1);
-    } else if (flags & DRAW_FLAG_SHADE) {
-        n_triangle_tex_draw(color, depth, texture,
-                            x1, y1, z1, w1, u1, v1, c1,
-                            x2, y2, z2, w2, u2, v2, c2,
-                            x3, y3, z3, w3, u3, v3, c3);
-    } else if (flags & DRAW_FLAG_WIREFRAME) {
-        n_triangle_wire_draw(color, x1, y1, x2, y2, x3, y3, c1);
-    } else if (flags & DRAW_FLAG_DOT) {
-        n_triangle_dots_draw(color, x1, y1, x2, y2, x3, y3, c1);
+    for (i = 0; i < bins.tris_count; i++) {
+        const raster_tri_t* t = &bins.tris[i];
+        for (ty = t->ty0; ty <= t->ty1; ty++) {
+            for (tx = t->tx0; tx <= t->tx1; tx++) {
+                bins.refs[bins.tile_fill[ty * bins.tiles_x + tx]++] = i;
+            }
+        }
     }
+
+    x_jobs_run(bins_tile_job, 0, tiles);
 }
 
 typedef struct {
@@ -494,12 +2557,136 @@ typedef struct {
 face_t faces[10];
 int faces_count = 0;
 
+static struct {
+    vec3_t* view;
+    uint16_t* outcode;
+    uint8_t* used;
+    int capacity;
+    uint8_t* front;
+    int face_capacity;
+} xform;
+
+static struct {
+    vec3_t direction;
+    float intensity;
+    float ambient;
+    int smooth;
+    uint32_t version;
+} light = { vec3_down, 1.0f, 0.3f, 0, 1 };
+
+void
+n_light_set(vec3_t direction, float intensity, float ambient) {
+    light.direction = v3_normalized(direction);
+    light.intensity = intensity;
+    light.ambient = ambient;
+    light.smooth = 1;
+    light.version++;
+}
+
+static mat4_t
+m4_normal(mat4_t m) {
+    vec3_t c0 = {{ m.cols[0].x, m.cols[0].y, m.cols[0].z }};
+    vec3_t c1 = {{ m.cols[1].x, m.cols[1].y, m.cols[1].z }};
+    vec3_t c2 = {{ m.cols[2].x, m.cols[2].y, m.cols[2].z }};
+    vec3_t n0 = v3_cross(c1, c2), n1 = v3_cross(c2, c0), n2 = v3_cross(c0, c1);
+    float s = v3_dot(c0, n0) < 0 ? -1.0f : 1.0f;
+    mat4_t res = mat4_identity;
+    res.cols[0] = (vec4_t) {{ n0.x * s, n0.y * s, n0.z * s, 0 }};
+    res.cols[1] = (vec4_t) {{ n1.x * s, n1.y * s, n1.z * s, 0 }};
+    res.cols[2] = (vec4_t) {{ n2.x * s, n2.y * s, n2.z * s, 0 }};
+    return res;
+}
+
+static float
+light_factor(vec3_t n) {
+    float factor = light.intensity * -v3_dot(n, light.direction);
+    return MIN(MAX(light.ambient, factor), 1.0f);
+}
+
+#define N_LIGHT_CACHE 32
+
+typedef struct {
+    const void* vertices;
+    const void* normals;
+    const void* colors;
+    int count;
+    mat4_t transform;
+    uint32_t version;
+    uint32_t* lit;
+    int capacity;
+} light_cache_t;
+
+static struct {
+    light_cache_t entries[N_LIGHT_CACHE];
+    int next;
+} lights;
+
+static int
+m4_same(const mat4_t* a, const mat4_t* b) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (a->cols[i].x != b->cols[i].x || a->cols[i].y != b->cols[i].y ||
+            a->cols[i].z != b->cols[i].z || a->cols[i].w != b->cols[i].w) return 0;
+    }
+    return 1;
+}
+
+static const uint32_t*
+light_vertices(const mesh_t* mesh, int vertex_count) {
+    light_cache_t* e = 0;
+    int i;
+
+    if (!light.smooth || !mesh->normals || (int)da_size(mesh->normals) < vertex_count * 3) return 0;
+
+    for (i = 0; i < N_LIGHT_CACHE; i++) {
+        if (lights.entries[i].vertices == mesh->vertices->data && m4_same(&lights.entries[i].transform, &mesh->transform)) {
+            e = &lights.entries[i];
+            break;
+        }
+    }
+    if (e && e->normals == mesh->normals->data && e->colors == mesh->colors->data &&
+        e->count == vertex_count && e->version == light.version) {
+        return e->lit;
+    }
+    if (!e) {
+        e = &lights.entries[lights.next];
+        lights.next = (lights.next + 1) % N_LIGHT_CACHE;
+    }
+    if (vertex_count > e->capacity) {
+        e->lit = e->lit ? x_realloc(e->lit, sizeof(uint32_t) * vertex_count, 0)
+                        : x_alloc(sizeof(uint32_t) * vertex_count, 0);
+        e->capacity = vertex_count;
+    }
+
+    {
+        const vec3_t* normals = (const vec3_t*)mesh->normals->data;
+        const uint32_t* colors = (const uint32_t*)mesh->colors->data;
+        mat4_t normal = m4_normal(mesh->transform);
+        for (i = 0; i < vertex_count; i++) {
+            vec4_t n = m4_mul_v4(normal, (vec4_t) {{ normals[i].x, normals[i].y, normals[i].z, 0 }});
+            vec3_t nw = {{ n.x, n.y, n.z }};
+            float len = v3_length(nw);
+            float factor = len > 0.0f ? light_factor(v3_scale(nw, 1.0f / len)) : light.ambient;
+            e->lit[i] = n_color_percent(colors[i], factor);
+        }
+    }
+
+    e->vertices = mesh->vertices->data;
+    e->normals = mesh->normals->data;
+    e->colors = mesh->colors->data;
+    e->count = vertex_count;
+    e->transform = mesh->transform;
+    e->version = light.version;
+    return e->lit;
+}
+
 void
-n_mesh_draw(uint32_t* color, float* depth,
+n_mesh_draw(uint32_t* color, void* depth,
             int w, int h,
             mesh_t mesh, mat4_t view, mat4_t proj) {
     int i, j;
     int culling = flags & DRAW_FLAG_CULLING;
+    triangle_kernel_t kernel = kernels[N_KERNEL_KEY(flags)];
 
     if (!mesh.indices || da_size(mesh.indices) == 0) {
         return;
@@ -513,63 +2700,125 @@ n_mesh_draw(uint32_t* color, float* depth,
                   da_size(mesh.uvs) > 0 && da_size(mesh.uv_indices) > 0);
     */
 
-    for (i = 0; i < mesh.indices->count; i += 3) {
-        uint32_t* indices = da_get(mesh.indices, i);
-        uint32_t* uv_indices = da_get(mesh.uv_indices, i);
-        vec3_t v1 = *(vec3_t*) da_get(mesh.vertices, (indices[0] - 1) * 3);
-        vec3_t v2 = *(vec3_t*) da_get(mesh.vertices, (indices[1] - 1) * 3);
-        vec3_t v3 = *(vec3_t*) da_get(mesh.vertices, (indices[2] - 1) * 3);
-        uint32_t c1 = *(uint32_t*) da_get(mesh.colors, (indices[0] - 1));
-        uint32_t c2 = *(uint32_t*) da_get(mesh.colors, (indices[1] - 1));
-        uint32_t c3 = *(uint32_t*) da_get(mesh.colors, (indices[2] - 1));
-        vec2_t tc1 = *(vec2_t*) da_get(mesh.uvs, (uv_indices[0] - 1) * 2);
-        vec2_t tc2 = *(vec2_t*) da_get(mesh.uvs, (uv_indices[1] - 1) * 2);
-        vec2_t tc3 = *(vec2_t*) da_get(mesh.uvs, (uv_indices[2] - 1) * 2);
-
-        vec4_t projection_points[3] = {
-            {{ v1.x, v1.y, v1.z, 1 }},
-            {{ v2.x, v2.y, v2.z, 1 }},
-            {{ v3.x, v3.y, v3.z, 1 }}
-        };
-        mat4_t model = mesh.transform;
-
-        {
-            for (j = 0; j < 3; j++) {
-                projection_points[j] = m4_mul_v4(model, projection_points[j]);
-                projection_points[j] = m4_mul_v4(view, projection_points[j]);
+    const vec3_t* vertices = (const vec3_t*)mesh.vertices->data;
+    const uint32_t* indices = (const uint32_t*)mesh.indices->data;
+    const uint32_t* uv_indices = (const uint32_t*)mesh.uv_indices->data;
+    const uint32_t* colors = (const uint32_t*)mesh.colors->data;
+    const vec2_t* uvs = (const vec2_t*)mesh.uvs->data;
+    int vertex_count = (int)(da_size(mesh.vertices) / 3);
+    int face_count = (int)(mesh.indices->count / 3);
+    mat4_t model_view = m4_mul(view, mesh.transform);
+    const uint32_t* lit = light_vertices(&mesh, vertex_count);
+    mat4_t normal = lit ? mat4_identity : m4_normal(mesh.transform);
+
+    if (vertex_count > xform.capacity) {
+        int capacity = MAX(vertex_count, xform.capacity * 2);
+        xform.view = xform.view ? x_realloc(xform.view, sizeof(vec3_t) * capacity, 0)
+                                : x_alloc(sizeof(vec3_t) * capacity, 0);
+        xform.outcode = xform.outcode ? x_realloc(xform.outcode, sizeof(uint16_t) * capacity, 0)
+                                      : x_alloc(sizeof(uint16_t) * capacity, 0);
+        xform.used = xform.used ? x_realloc(xform.used, capacity, 0)
+                                : x_alloc(capacity, 0);
+        xform.capacity = capacity;
+    }
+    if (culling && face_count > xform.face_capacity) {
+        int capacity = MAX(face_count, xform.face_capacity * 2);
+        xform.front = xform.front ? x_realloc(xform.front, capacity, 0)
+                                  : x_alloc(capacity, 0);
+        xform.face_capacity = capacity;
+    }
+
+    if (culling) { /* BACKFACE CULLING */
+        mat4_t inv = m4_inv(model_view);
+        vec3_t eye = {{ inv.cols[0].w / inv.cols[3].w, inv.cols[1].w / inv.cols[3].w, inv.cols[2].w / inv.cols[3].w }};
+
+        x_mem_zero(xform.used, vertex_count);
+        for (i = 0; i < face_count; i++) {
+            const uint32_t* tri = indices + i * 3;
+            vec3_t v1 = vertices[tri[0] - 1];
+            vec3_t n = v3_cross(v3_sub(vertices[tri[1] - 1], v1), v3_sub(vertices[tri[2] - 1], v1));
+            xform.front[i] = v3_dot(n, v3_sub(eye, v1)) > 0;
+            if (xform.front[i]) {
+                xform.used[tri[0] - 1] = 1;
+                xform.used[tri[1] - 1] = 1;
+                xform.used[tri[2] - 1] = 1;
             }
         }
+    }
+
+    /* TRANSFORM */
+    for (j = 0; j < vertex_count; j++) {
+        if (culling && !xform.used[j]) continue;
+        vec4_t p = m4_mul_v4(model_view, (vec4_t) {{ vertices[j].x, vertices[j].y, vertices[j].z, 1 }});
+        xform.view[j] = *(vec3_t*)&p;
+        xform.outcode[j] = (uint16_t)point_outcode(xform.view[j]);
+    }
 
-        vec3_t v1_trans = *(vec3_t*)&projection_points[0];
-        vec3_t v2_trans = *(vec3_t*)&projection_points[1];
-        vec3_t v3_trans = *(vec3_t*)&projection_points[2];
+    for (i = 0; i < mesh.indices->count; i += 3) {
+        if (culling && !xform.front[i / 3]) continue;
 
-        polygon_t polygon = polygon_create(v1_trans, v2_trans, v3_trans, tc1, tc2, tc3);
-        polygon_clip(&polygon);
+        const uint32_t* tri = indices + i;
+        const uint32_t* uv_tri = uv_indices + i;
+        uint32_t c1, c2, c3;
+        vec2_t tc1 = uvs[uv_tri[0] - 1];
+        vec2_t tc2 = uvs[uv_tri[1] - 1];
+        vec2_t tc3 = uvs[uv_tri[2] - 1];
 
-        if (polygon.vertices_count < 3) {
-            continue;
-        }
+        vec3_t v1_trans = xform.view[tri[0] - 1];
+        vec3_t v2_trans = xform.view[tri[1] - 1];
+        vec3_t v3_trans = xform.view[tri[2] - 1];
+
+        int o1 = xform.outcode[tri[0] - 1];
+        int o2 = xform.outcode[tri[1] - 1];
+        int o3 = xform.outcode[tri[2] - 1];
+        if (o1 & o2 & o3 & OUTCODE_FRUSTUM) continue;
+
+        int straddle = o1 | o2 | o3;
+        int clip = (straddle & OUTCODE_DEPTH) | ((straddle >> OUTCODE_GUARD_SHIFT) & ~OUTCODE_DEPTH & OUTCODE_FRUSTUM);
 
         faces_count = 0;
 
-        for (j = 0; j < polygon.vertices_count - 2; j++) {
-            faces[faces_count].v1 = (vec4_t) {{ polygon.vertices[0].x, polygon.vertices[0].y, polygon.vertices[0].z, 1 }};
-            faces[faces_count].v2 = (vec4_t) {{ polygon.vertices[j + 1].x, polygon.vertices[j + 1].y, polygon.vertices[j + 1].z, 1 }};
-            faces[faces_count].v3 = (vec4_t) {{ polygon.vertices[j + 2].x, polygon.vertices[j + 2].y, polygon.vertices[j + 2].z, 1 }};
+        if (!clip) {
+            faces[0].v1 = (vec4_t) {{ v1_trans.x, v1_trans.y, v1_trans.z, 1 }};
+            faces[0].v2 = (vec4_t) {{ v2_trans.x, v2_trans.y, v2_trans.z, 1 }};
+            faces[0].v3 = (vec4_t) {{ v3_trans.x, v3_trans.y, v3_trans.z, 1 }};
+            faces[0].uv1 = tc1;
+            faces[0].uv2 = tc2;
+            faces[0].uv3 = tc3;
+            faces_count = 1;
+        } else { /* CLIP */
+            polygon_t polygon = polygon_create(v1_trans, v2_trans, v3_trans, tc1, tc2, tc3);
+            polygon_clip_mask(&polygon, clip);
+
+            for (j = 0; j < polygon.vertices_count - 2; j++) {
+                faces[faces_count].v1 = (vec4_t) {{ polygon.vertices[0].x, polygon.vertices[0].y, polygon.vertices[0].z, 1 }};
+                faces[faces_count].v2 = (vec4_t) {{ polygon.vertices[j + 1].x, polygon.vertices[j + 1].y, polygon.vertices[j + 1].z, 1 }};
+                faces[faces_count].v3 = (vec4_t) {{ polygon.vertices[j + 2].x, polygon.vertices[j + 2].y, polygon.vertices[j + 2].z, 1 }};
+
+                faces[faces_count].uv1 = polygon.uvs[0];
+                faces[faces_count].uv2 = polygon.uvs[j + 1];
+                faces[faces_count].uv3 = polygon.uvs[j + 2];
+                faces_count++;
+            }
+        }
 
-            faces[faces_count].uv1 = polygon.uvs[0];
-            faces[faces_count].uv2 = polygon.uvs[j + 1];
-            faces[faces_count].uv3 = polygon.uvs[j + 2];
-            faces_count++;
+        if (!faces_count) {
+            continue;
         }
 
-        vec3_t e1 = v3_sub(v2, v1);
-        vec3_t e2 = v3_sub(v3, v1);
-        e1 = v3_normalized(e1);
-        e2 = v3_normalized(e2);
-        vec3_t n = v3_cross(e1, e2);
-        n = v3_normalized(n);
+        if (lit) {
+            c1 = lit[tri[0] - 1];
+            c2 = lit[tri[1] - 1];
+            c3 = lit[tri[2] - 1];
+        } else { /* LIGHT PER FACE */
+            vec3_t v1 = vertices[tri[0] - 1];
+            vec3_t n = v3_cross(v3_sub(vertices[tri[1] - 1], v1), v3_sub(vertices[tri[2] - 1], v1));
+            vec4_t nw = m4_mul_v4(normal, (vec4_t) {{ n.x, n.y, n.z, 0 }});
+            float factor = light_factor(v3_normalized((vec3_t) {{ nw.x, nw.y, nw.z }}));
+            c1 = n_color_percent(colors[tri[0] - 1], factor);
+            c2 = n_color_percent(colors[tri[1] - 1], factor);
+            c3 = n_color_percent(colors[tri[2] - 1], factor);
+        }
 
         for (j = 0; j < faces_count; j++) {
             { /* PROJECTION */
@@ -601,15 +2850,7 @@ n_mesh_draw(uint32_t* color, float* depth,
                                              faces[j].v3.x, faces[j].v3.y);
                 if (culling && area2 < 0) continue;
 
-                { /* CALCULATE LIGHT INTENCITY PER FACE */
-                    float factor = -v3_dot(n, vec3_down);
-                    factor = MIN(MAX(0.3f, factor), 1.0f);
-                    c1 = n_color_percent(c1, factor);
-                    c2 = n_color_percent(c2, factor);
-                    c3 = n_color_percent(c3, factor);
-                }
-
-                n_triangle_draw(color, depth, mesh.texture,
+                triangle_emit(color, depth, kernel, mesh.texture,
                     faces[j].v1.x, faces[j].v1.y, faces[j].v1.z, faces[j].v1.w, faces[j].uv1.x, faces[j].uv1.y, c1,
                     faces[j].v3.x, faces[j].v3.y, faces[j].v3.z, faces[j].v3.w, faces[j].uv3.x, faces[j].uv3.y, c3,
                     faces[j].v2.x, faces[j].v2.y, faces[j].v2.z, faces[j].v2.w, faces[j].uv2.x, faces[j].uv2.y, c2);
@@ -700,13 +2941,111 @@ nude_mesh_queue_add(mesh_queue_t* queue, mesh_t mesh, mat4_t view, mat4_t proj)
     queue->count++;
 }
 
+#ifdef SIMD_WIDTH
+#define N_CULL_LANES SIMD_WIDTH
+#else
+#define N_CULL_LANES 1
+#endif
+
+static struct {
+    float* spheres;
+    uint8_t* visible;
+    int capacity;
+} cull;
+
+static void
+cull_spheres(mesh_queue_t* queue, int stride) {
+    float* cx = cull.spheres;
+    float* cy = cx + stride;
+    float* cz = cy + stride;
+    float* cr = cz + stride;
+    int i;
+
+    for (i = 0; i < stride; i++) {
+        cx[i] = cy[i] = cz[i] = 0;
+        cr[i] = 3.402823466e+38f;
+    }
+    for (i = 0; i < queue->count; i++) {
+        mesh_t* mesh = &queue->entries[i].mesh;
+        vec3_t lo = mesh->bounds_min, hi = mesh->bounds_max;
+        if (!(hi.x > lo.x || hi.y > lo.y || hi.z > lo.z)) continue;
+
+        mat4_t model_view = m4_mul(queue->entries[i].view, mesh->transform);
+        vec3_t half = v3_scale(v3_sub(hi, lo), 0.5f);
+        vec4_t c = m4_mul_v4(model_view, (vec4_t) {{ lo.x + half.x, lo.y + half.y, lo.z + half.z, 1 }});
+        float sx = v4_sqr_length(model_view.cols[0]);
+        float sy = v4_sqr_length(model_view.cols[1]);
+        float sz = v4_sqr_length(model_view.cols[2]);
+        float scale = MAX(MAX(sx, sy), sz);
+        cx[i] = c.x;
+        cy[i] = c.y;
+        cz[i] = c.z;
+        cr[i] = mm_sqrt(v3_sqr_length(half) * scale) * 1.01f;
+    }
+}
+
+static void
+cull_queue(mesh_queue_t* queue) {
+    const plane_t* planes = frustum_planes();
+    int stride = (queue->count + N_CULL_LANES - 1) & ~(N_CULL_LANES - 1);
+    int i, p;
+
+    if (stride > cull.capacity) {
+        int capacity = MAX(stride, cull.capacity * 2);
+        if (cull.spheres) {
+            x_free(cull.spheres, 0);
+            x_free(cull.visible, 0);
+        }
+        cull.spheres = x_alloc(sizeof(float) * 4 * capacity, 0);
+        cull.visible = x_alloc(capacity, 0);
+        cull.capacity = capacity;
+    }
+    cull_spheres(queue, stride);
+
+    for (i = 0; i < stride; i += N_CULL_LANES) {
+        const float* cx = cull.spheres + i;
+        const float* cy = cx + stride;
+        const float* cz = cy + stride;
+        const float* cr = cz + stride;
+#ifdef SIMD_WIDTH
+        vf_t x = vf_load(cx), y = vf_load(cy), z = vf_load(cz);
+        vf_t r = vf_sub(vf_set1(0), vf_load(cr));
+        vf_t out = vf_set1(0);
+        int k, mask;
+        for (p = 0; p < FRUSTUM_COUNT; p++) {
+            vf_t d = vf_add(vf_add(vf_mul(x, vf_set1(planes[p].norm.x)),
+                                   vf_mul(y, vf_set1(planes[p].norm.y))),
+                            vf_sub(vf_mul(z, vf_set1(planes[p].norm.z)),
+                                   vf_set1(v3_dot(planes[p].norm, planes[p].point))));
+            out = vf_or(out, vf_gt(r, d));
+        }
+        mask = vf_mask(out);
+        for (k = 0; k < SIMD_WIDTH; k++) cull.visible[i + k] = !((mask >> k) & 1);
+#else
+        cull.visible[i] = 1;
+        for (p = 0; p < FRUSTUM_COUNT; p++) {
+            vec3_t c = {{ *cx, *cy, *cz }};
+            if (v3_dot(planes[p].norm, v3_sub(c, planes[p].point)) < -*cr) cull.visible[i] = 0;
+        }
+#endif
+    }
+}
+
 void
-nude_render(mesh_queue_t* queue, uint32_t* color, float* depth, int w, int h) {
+nude_render(mesh_queue_t* queue, uint32_t* color, void* depth, int w, int h) {
     if (!queue) return;
 
     int i;
+    int visibility = (flags & DRAW_FLAG_VISBUFFER) && (flags & DRAW_FLAG_SHADE) &&
+                     !(flags & (DRAW_FLAG_WIREFRAME | DRAW_FLAG_DOT | DRAW_FLAG_FULLRECT));
+    int record = visibility || (flags & DRAW_FLAG_BINNING);
+
+    cull_queue(queue);
+    if (record) bins_begin(color, depth);
     for (i = 0; i < queue->count; i++) {
         mesh_queue_entry_t* entry = &queue->entries[i];
+        if (!cull.visible[i]) continue;
         n_mesh_draw(color, depth, w, h, entry->mesh, entry->view, entry->proj);
     }
+    if (record) bins_flush(visibility);
 }
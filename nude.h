@@ -12,9 +12,20 @@ typedef enum {
     DRAW_FLAG_BACKFACE = 1 << 3,
     DRAW_FLAG_CULLING = 1 << 4,
     DRAW_FLAG_NORMALS = 1 << 5,
-    DRAW_FLAG_FULLRECT = 1 << 6
+    DRAW_FLAG_FULLRECT = 1 << 6,
+    DRAW_FLAG_BINNING = 1 << 7,
+    DRAW_FLAG_SUBPIXEL = 1 << 8,
+    DRAW_FLAG_VISBUFFER = 1 << 9,
+    DRAW_FLAG_LAZYCLEAR = 1 << 10,
+    DRAW_FLAG_TILEDFB = 1 << 11
 } drawing_flags_t;
 
+typedef enum {
+    DEPTH_FORMAT_F32,
+    DEPTH_FORMAT_UNORM24,
+    DEPTH_FORMAT_UNORM16
+} depth_format_t;
+
 typedef struct {
     mesh_t mesh;
     mat4_t view;
@@ -35,7 +46,7 @@ typedef struct {
 
 typedef struct {
     uint32_t* color;
-    uint32_t* depth;
+    void* depth;
     uint32_t width;
     uint32_t height;
 } framebuffer_t;
@@ -53,9 +64,15 @@ void n_ctx_proj_set(mat4_t mat);
 void n_flag_toggle(drawing_flags_t flag);
 void n_size_set(int width, int height);
 void n_clear_color_set(uint32_t color);
-void n_clear(uint32_t* buffer, float* depth);
+void n_tex_span_set(int pixels);
+void n_tex_filter_set(int filter);
+void n_depth_format_set(depth_format_t format);
+void n_light_set(vec3_t direction, float intensity, float ambient);
+void n_clear(uint32_t* buffer, void* depth);
+void n_clear_resolve(uint32_t* buffer, void* depth);
+void n_layout_resolve(uint32_t* buffer);
 int n_point_draw(uint32_t* buffer, uint32_t x, uint32_t y, uint32_t color);
-int n_depth_set(float* buffer, unsigned int x, unsigned int y, float depth);
+int n_depth_set(void* buffer, unsigned int x, unsigned int y, float depth);
 void n_line2d_draw(uint32_t* buffer, int x1, int y1, int x2, int y2, uint32_t color);
 void n_line2d_draw_gradient(uint32_t* buffer, int x1, int y1, int x2, int y2, uint32_t color1, uint32_t color2);
 void n_texture_draw(uint32_t* buffer, int w, int h);
@@ -63,16 +80,21 @@ void n_texture_draw(uint32_t* buffer, int w, int h);
 void n_grid_line_draw(uint32_t* buffer, int w, int h, int size);
 void n_grid_dot_draw(uint32_t* buffer, int w, int h, int size, float time);
 void n_rect_fill_draw(uint32_t* buffer, int sx, int sy, int width, int height, uint32_t color);
+void n_span_fill(uint32_t* buffer, int x, int y, const uint32_t* colors, int count);
+void n_hline(uint32_t* buffer, int x0, int x1, int y, uint32_t color);
+void n_vline(uint32_t* buffer, int x, int y0, int y1, uint32_t color);
+void n_rect_fill(uint32_t* buffer, int x0, int y0, int x1, int y1, uint32_t color);
 void n_triangle_dots_draw(uint32_t* buffer, float x1, float y1, float x2, float y2, float x3, float y3, uint32_t color);
 void n_triangle_wire_draw(uint32_t* buffer, float x1, float y1, float x2, float y2, float x3, float y3, uint32_t color);
 uint32_t n_color_percent(uint32_t color, float precent);
 uint32_t n_color_mix3(uint32_t c1, uint32_t c2, uint32_t c3);
 
 void n_draw_ray(uint32_t* buffer, vec3_t o, vec3_t d, uint32_t color);
-void n_mesh_draw(uint32_t* buffer, float* depth, int w, int h, mesh_t mesh, mat4_t view, mat4_t proj);
-void n_triangle_draw(uint32_t* buffer, float* depth, const void* texture, int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1, int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2, int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3);
-void n_triangle_tex_draw(uint32_t* color, float* depth, const void* texture, int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1, int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2, int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3);
-void n_triangle_fill_draw(uint32_t* color, float* depth, int x1, int y1, float z1, uint32_t c1, int x2, int y2, float z2, uint32_t c2, int x3, int y3, float z3, uint32_t c3);
+void n_mesh_draw(uint32_t* buffer, void* depth, int w, int h, mesh_t mesh, mat4_t view, mat4_t proj);
+void n_triangle_draw(uint32_t* buffer, void* depth, const void* texture, int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1, int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2, int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3);
+void n_triangle_draw_subpixel(uint32_t* buffer, void* depth, const void* texture, float x1, float y1, float z1, float w1, float u1, float v1, uint32_t c1, float x2, float y2, float z2, float w2, float u2, float v2, uint32_t c2, float x3, float y3, float z3, float w3, float u3, float v3, uint32_t c3);
+void n_triangle_tex_draw(uint32_t* color, void* depth, const void* texture, int x1, int y1, float z1, float w1, float u1, float v1, uint32_t c1, int x2, int y2, float z2, float w2, float u2, float v2, uint32_t c2, int x3, int y3, float z3, float w3, float u3, float v3, uint32_t c3);
+void n_triangle_fill_draw(uint32_t* color, void* depth, int x1, int y1, float z1, uint32_t c1, int x2, int y2, float z2, uint32_t c2, int x3, int y3, float z3, uint32_t c3);
 
 
 void n_mesh_draw_wireframe(texture2d_t* texture, const mesh_t* mesh, const mat4_t model, const mat4_t view, const mat4_t proj, unsigned int color);
@@ -85,6 +107,8 @@ void nude_mesh_queue_clear(mesh_queue_t* queue);
 
 void nude_mesh_queue_add(mesh_queue_t* queue, mesh_t mesh, mat4_t view, mat4_t proj);
 
-void nude_render(mesh_queue_t* queue, uint32_t* color, float* depth, int w, int h);
+void nude_render(mesh_queue_t* queue, uint32_t* color, void* depth, int w, int h);
+
+void nude_threads_set(int count);
 
 #endif
@@ -22,7 +22,9 @@ mesh_obj_load(const char* file_path) {
         da_create(sizeof(float)),
         da_create(sizeof(uint32_t)),
         mat4_identity,
-        NULL
+        NULL,
+        vec3_zero,
+        vec3_zero
     };
 
     FILE* f = fopen(file_path, "r");
@@ -90,5 +92,7 @@ mesh_obj_load(const char* file_path) {
 
     fclose(f);
 
+    mesh_bounds_compute(&mesh);
+    mesh_normals_compute(&mesh);
     return mesh;
 }
@@ -0,0 +1,114 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#endif
+
+#if defined(SIMD_AVX2)
+
+#include <immintrin.h>
+
+#define SIMD_WIDTH 8
+
+typedef __m256 vf_t;
+typedef __m256i vi_t;
+
+#define vf_set1(a) _mm256_set1_ps(a)
+#define vf_ramp() _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)
+#define vf_load(p) _mm256_loadu_ps(p)
+#define vf_store(p, a) _mm256_storeu_ps(p, a)
+#define vf_add(a, b) _mm256_add_ps(a, b)
+#define vf_sub(a, b) _mm256_sub_ps(a, b)
+#define vf_mul(a, b) _mm256_mul_ps(a, b)
+#define vf_div(a, b) _mm256_div_ps(a, b)
+#define vf_and(a, b) _mm256_and_ps(a, b)
+#define vf_or(a, b) _mm256_or_ps(a, b)
+#define vf_gt(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define vf_ge(a, b) _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+#define vf_eq(a, b) _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define vf_mask(a) _mm256_movemask_ps(a)
+#define vf_select(m, a, b) _mm256_blendv_ps(b, a, m)
+#define vf_min(a, b) _mm256_min_ps(a, b)
+#define vf_max(a, b) _mm256_max_ps(a, b)
+#define vf_to_vi(a) _mm256_cvttps_epi32(a)
+#define vf_as_vi(a) _mm256_castps_si256(a)
+#define vf_stream(p, a) _mm256_stream_ps(p, a)
+
+#define vi_set1(a) _mm256_set1_epi32(a)
+#define vi_load(p) _mm256_loadu_si256((const __m256i*)(p))
+#define vi_store(p, a) _mm256_storeu_si256((__m256i*)(p), a)
+#define vi_select(m, a, b) _mm256_blendv_epi8(b, a, _mm256_castps_si256(m))
+#define vi_add(a, b) _mm256_add_epi32(a, b)
+#define vi_gt(a, b) _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))
+#define vi_to_vf(a) _mm256_cvtepi32_ps(a)
+#define vi_and(a, b) _mm256_and_si256(a, b)
+#define vi_or(a, b) _mm256_or_si256(a, b)
+#define vi_xor(a, b) _mm256_xor_si256(a, b)
+#define vi_srl(a, n) _mm256_srli_epi32(a, n)
+#define vi_sll(a, n) _mm256_slli_epi32(a, n)
+#define vi_mul(a, b) _mm256_mullo_epi32(a, b)
+#define vi_mul16(a, b) _mm256_mullo_epi16(a, b)
+#define vi_stream(p, a) _mm256_stream_si256((__m256i*)(p), a)
+#define vi_load_u16(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(p)))
+#define vi_store_u16(p, a) _mm_storeu_si128((__m128i*)(p), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(a, a), 0x08)))
+
+#define simd_fence() _mm_sfence()
+
+#elif defined(SIMD_SSE2)
+
+#include <emmintrin.h>
+
+#define SIMD_WIDTH 4
+
+typedef __m128 vf_t;
+typedef __m128i vi_t;
+
+#define vf_set1(a) _mm_set1_ps(a)
+#define vf_ramp() _mm_setr_ps(0, 1, 2, 3)
+#define vf_load(p) _mm_loadu_ps(p)
+#define vf_store(p, a) _mm_storeu_ps(p, a)
+#define vf_add(a, b) _mm_add_ps(a, b)
+#define vf_sub(a, b) _mm_sub_ps(a, b)
+#define vf_mul(a, b) _mm_mul_ps(a, b)
+#define vf_div(a, b) _mm_div_ps(a, b)
+#define vf_and(a, b) _mm_and_ps(a, b)
+#define vf_or(a, b) _mm_or_ps(a, b)
+#define vf_gt(a, b) _mm_cmpgt_ps(a, b)
+#define vf_ge(a, b) _mm_cmpge_ps(a, b)
+#define vf_eq(a, b) _mm_cmpeq_ps(a, b)
+#define vf_mask(a) _mm_movemask_ps(a)
+#define vf_select(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define vf_min(a, b) _mm_min_ps(a, b)
+#define vf_max(a, b) _mm_max_ps(a, b)
+#define vf_to_vi(a) _mm_cvttps_epi32(a)
+#define vf_as_vi(a) _mm_castps_si128(a)
+#define vf_stream(p, a) _mm_stream_ps(p, a)
+
+#define vi_set1(a) _mm_set1_epi32(a)
+#define vi_load(p) _mm_loadu_si128((const __m128i*)(p))
+#define vi_store(p, a) _mm_storeu_si128((__m128i*)(p), a)
+#define vi_select(m, a, b) _mm_or_si128(_mm_and_si128(_mm_castps_si128(m), a), _mm_andnot_si128(_mm_castps_si128(m), b))
+#define vi_add(a, b) _mm_add_epi32(a, b)
+#define vi_gt(a, b) _mm_castsi128_ps(_mm_cmpgt_epi32(a, b))
+#define vi_to_vf(a) _mm_cvtepi32_ps(a)
+#define vi_and(a, b) _mm_and_si128(a, b)
+#define vi_or(a, b) _mm_or_si128(a, b)
+#define vi_xor(a, b) _mm_xor_si128(a, b)
+#define vi_srl(a, n) _mm_srli_epi32(a, n)
+#define vi_sll(a, n) _mm_slli_epi32(a, n)
+#define vi_mul(a, b) _mm_unpacklo_epi32(_mm_shuffle_epi32(_mm_mul_epu32(a, b), 0x08), _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 0x08))
+#define vi_mul16(a, b) _mm_mullo_epi16(a, b)
+#define vi_stream(p, a) _mm_stream_si128((__m128i*)(p), a)
+#define vi_load_u16(p) _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(p)), _mm_setzero_si128())
+#define vi_store_u16(p, a) _mm_storel_epi64((__m128i*)(p), _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, _mm_set1_epi32(0x8000)), _mm_setzero_si128()), _mm_set1_epi16((short)0x8000)))
+
+#define simd_fence() _mm_sfence()
+
+#endif
+
+#endif
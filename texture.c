@@ -36,6 +36,35 @@ texture_get_color_from_asset(const struct asset_texture_t* texture, float u, flo
     return texture_get_color(u, v);
 }
 
+uint32_t
+texture_get_color_from_asset_level(const struct asset_texture_t* texture, float u, float v, uint32_t level) {
+    if (texture) {
+        return asset_texture_get_color_level((const asset_texture_t*)texture, u, v, level);
+    }
+    return texture_get_color(u, v);
+}
+
+void
+texture_sample_from_asset(const struct asset_texture_t* texture, const float* u, const float* v,
+                          uint32_t* out, int count, uint32_t level, int filter) {
+    int i;
+    if (texture) {
+        asset_texture_sample((const asset_texture_t*)texture, u, v, out, count, level, filter);
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        out[i] = texture_get_color(u[i], v[i]);
+    }
+}
+
+uint32_t
+texture_level_from_asset(const struct asset_texture_t* texture, float uv_area) {
+    if (texture) {
+        return asset_texture_level((const asset_texture_t*)texture, uv_area);
+    }
+    return 0;
+}
+
 void
 textures_load(const char* path) {
     FILE* input = fopen(path, "rb");
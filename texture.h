@@ -11,6 +11,9 @@ extern const uint32_t texture_raw[];
 
 uint32_t texture_get_color(float u, float v);
 uint32_t texture_get_color_from_asset(const struct asset_texture_t* texture, float u, float v);
+uint32_t texture_get_color_from_asset_level(const struct asset_texture_t* texture, float u, float v, uint32_t level);
+uint32_t texture_level_from_asset(const struct asset_texture_t* texture, float uv_area);
+void texture_sample_from_asset(const struct asset_texture_t* texture, const float* u, const float* v, uint32_t* out, int count, uint32_t level, int filter);
 void textures_load(const char* path);
 
 #endif
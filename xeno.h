@@ -26,4 +26,11 @@ void x_mouse_position_get(int32_t* out_x, int32_t* out_y);
 uint64_t x_file_size(const char* file_path);
 uint8_t* x_file_read(const char* file_path, uint8_t* buffer, uint64_t size);
 
+typedef void (*x_job_proc_t)(void* user, int index);
+
+int x_cpu_count();
+void x_jobs_init(int thread_count);
+void x_jobs_term();
+void x_jobs_run(x_job_proc_t proc, void* user, int count);
+
 #endif
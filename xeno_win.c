@@ -41,6 +41,20 @@ static struct {
     WAVEHDR hdr;
 } state;
 
+#define X_JOBS_MAX_THREADS 64
+
+static struct {
+    HANDLE threads[X_JOBS_MAX_THREADS];
+    HANDLE start[X_JOBS_MAX_THREADS];
+    HANDLE done;
+    int count;
+    volatile LONG next;
+    volatile LONG quit;
+    x_job_proc_t proc;
+    void* user;
+    int jobs;
+} jobs;
+
 static LARGE_INTEGER frequency;
 static double clock_frequency;
 static double awake_time;
@@ -501,3 +515,83 @@ x_file_read(const char* file_path, uint8_t* buffer, uint64_t size) {
 
     return buffer;
 }
+
+int
+x_cpu_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+static void
+x_jobs_drain() {
+    LONG index;
+    while ((index = InterlockedIncrement(&jobs.next) - 1) < jobs.jobs) {
+        jobs.proc(jobs.user, (int)index);
+    }
+}
+
+static DWORD WINAPI
+x_jobs_worker(LPVOID param) {
+    HANDLE start = jobs.start[(intptr_t)param];
+    while (1) {
+        WaitForSingleObject(start, INFINITE);
+        if (jobs.quit) break;
+        x_jobs_drain();
+        ReleaseSemaphore(jobs.done, 1, 0);
+    }
+    return 0;
+}
+
+void
+x_jobs_init(int thread_count) {
+    int i;
+    x_jobs_term();
+
+    thread_count = thread_count < X_JOBS_MAX_THREADS ? thread_count : X_JOBS_MAX_THREADS;
+    if (thread_count <= 0) return;
+
+    jobs.quit = 0;
+    jobs.done = CreateSemaphoreA(0, 0, X_JOBS_MAX_THREADS, 0);
+    for (i = 0; i < thread_count; i++) {
+        jobs.start[i] = CreateEventA(0, FALSE, FALSE, 0);
+        jobs.threads[i] = CreateThread(0, 0, x_jobs_worker, (LPVOID)(intptr_t)i, 0, 0);
+    }
+    jobs.count = thread_count;
+}
+
+void
+x_jobs_term() {
+    int i;
+    if (!jobs.count) return;
+
+    jobs.quit = 1;
+    for (i = 0; i < jobs.count; i++) {
+        SetEvent(jobs.start[i]);
+    }
+    WaitForMultipleObjects(jobs.count, jobs.threads, TRUE, INFINITE);
+    for (i = 0; i < jobs.count; i++) {
+        CloseHandle(jobs.threads[i]);
+        CloseHandle(jobs.start[i]);
+    }
+    CloseHandle(jobs.done);
+    jobs.count = 0;
+}
+
+void
+x_jobs_run(x_job_proc_t proc, void* user, int count) {
+    int i, workers;
+    jobs.proc = proc;
+    jobs.user = user;
+    jobs.jobs = count;
+    jobs.next = 0;
+
+    workers = count - 1 < jobs.count ? count - 1 : jobs.count;
+    for (i = 0; i < workers; i++) {
+        SetEvent(jobs.start[i]);
+    }
+    x_jobs_drain();
+    for (i = 0; i < workers; i++) {
+        WaitForSingleObject(jobs.done, INFINITE);
+    }
+}